@@ -0,0 +1,85 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+#if defined(__linux__)
+    #include <sched.h>
+#endif
+
+#include "common.hpp"
+
+namespace false_sharing_example {
+
+// Index of the calling thread, shared by all counters: 0, 1, 2... in order of first use
+inline int Counter_Thread_Index() {
+    static std::atomic<int>  sNextIndex{0};
+    static thread_local auto sIndex = sNextIndex.fetch_add(1, std::memory_order::relaxed);
+    return sIndex;
+}
+
+// How a thread picks its shard: by a per-thread index (assigned on the thread's first use of any
+// ShardedCounter), or by the CPU it is running on (sched_getcpu(); per-thread off Linux).
+enum class ShardSelection { PerThread, PerCpu };
+
+// The no-share.cpp pattern as a reusable counter: increments go to one of several shards, each
+// on its own cache line, so threads on different shards never contend or falsely share. Reading
+// sums the shards: increments are relaxed, so read() is exact only once the writers are joined
+// (or otherwise synchronized with), and otherwise a value the counter had recently.
+//
+// Shards are picked modulo their number, so threads (or CPUs) beyond it share shards: still
+// correct, as every increment is an atomic read-modify-write, just contended again. Per-CPU
+// selection keeps the shard count fixed however many threads come and go, at the cost of a
+// sched_getcpu() (a vDSO call, ~a few ns) per increment.
+template <ShardSelection Selection = ShardSelection::PerThread>
+class ShardedCounter {
+  public:
+    // Rounded up to a power of two. Default: one per CPU.
+    explicit ShardedCounter(int aNumShards = Default_Num_Shards())
+        : mNumShards(static_cast<int>(std::bit_ceil(static_cast<unsigned>(aNumShards)))),
+          mShards(std::make_unique<Shard[]>(mNumShards)) {}
+
+    void Add(std::int64_t aAmount) {
+        auto& cShard = mShards[Shard_Index() & (mNumShards - 1)];
+        cShard.value.fetch_add(aAmount, std::memory_order::relaxed);
+    }
+    void Increment() { Add(1); }
+
+    std::int64_t read() const {
+        std::int64_t cTotal = 0;
+        for (int cShard = 0; cShard < mNumShards; ++cShard)
+            cTotal += mShards[cShard].value.load(std::memory_order::relaxed);
+        return cTotal;
+    }
+
+    int num_shards() const { return mNumShards; }
+
+    static int Default_Num_Shards() {
+        return std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    }
+
+  private:
+    struct alignas(cache_line_size) Shard {
+        std::atomic<std::int64_t> value{0};
+    };
+
+    static int Shard_Index() {
+#if defined(__linux__)
+        if constexpr (Selection == ShardSelection::PerCpu) {
+            auto cCpu = sched_getcpu();
+            if (cCpu >= 0)
+                return cCpu;
+        }
+#endif
+        return Counter_Thread_Index();
+    }
+
+    int                      mNumShards;
+    std::unique_ptr<Shard[]> mShards;
+};
+
+}  // namespace false_sharing_example
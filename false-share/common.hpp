@@ -2,6 +2,8 @@
 
 #include <cstddef>
 
+#include "Topology.hpp"
+
 // Common configuration for false sharing benchmarks
 namespace false_sharing_example {
 // Number of threads to use for multithreaded examples
@@ -13,10 +15,7 @@ constexpr size_t max_count = 1 << 27;  // 134,217,728
 // Number of increments per thread
 constexpr size_t count_per_thread = max_count / num_threads;
 
-// Cache line size for padding
-#if __cpp_lib_hardware_interference_size >= 201603
-constexpr size_t cache_line_size = std::hardware_destructive_interference_size;
-#else
-constexpr size_t cache_line_size = 64;  // Common cache line size
-#endif
+// Padding between per-thread data: 128 bytes on x86 (the adjacent-line prefetcher pairs 64-byte
+// lines) and Apple Silicon, 64 elsewhere (see hw-utils/Topology.hpp)
+constexpr size_t cache_line_size = hw_utils::sFalseSharingPadding;
 }  // namespace false_sharing_example
@@ -0,0 +1,580 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "Affinity.hpp"
+#include "PerfCounters.hpp"
+#include "Topology.hpp"
+
+// Contention sweep: every combination of thread count, stride, operation and memory order is run
+// for a warmup plus a number of timed repetitions, reporting the median and standard deviation of
+// the wall time, the throughput, and (where the PMU is available) hardware events per operation.
+//
+// Each thread hammers its own 8-byte atomic counter, placed stride bytes after the previous
+// thread's one: 0 shares a single counter (true sharing), 8 packs them (false sharing), and 64,
+// 128 or 256 give each its own cache line (or pair of lines, for adjacent-line prefetchers).
+//
+// Threads are pinned per --placement (Linux): compact puts threads 0 and 1 on SMT siblings, cores
+// on two cores of a socket, spread on two sockets, so each cost can be measured deliberately.
+//
+// Usage:
+//   ./driver --threads=1,2,4,8 --stride=0,8,64,128,256 --op=fetch_add,cas,store,increment
+//            --order=relaxed,acq_rel,seq_cst --placement=none,compact,cores,spread
+//            --ops=4194304 --warmup=1 --repetitions=5 --format=table|csv|json
+namespace false_sharing_example {
+
+enum class Operation {
+    FetchAdd,  // fetch_add(1)
+    CasLoop,   // compare_exchange_weak loop
+    Store,     // Plain store of the loop index
+    Increment  // Load + store: not atomic as a whole (no lock prefix), shared counters lose counts
+};
+
+enum class Order { Relaxed, AcqRel, SeqCst };
+
+enum class Format { Table, Csv, Json };
+
+constexpr const char* Operation_Name(Operation aOperation) {
+    switch (aOperation) {
+        case Operation::FetchAdd:
+            return "fetch_add";
+        case Operation::CasLoop:
+            return "cas";
+        case Operation::Store:
+            return "store";
+        default:
+            return "increment";
+    }
+}
+
+constexpr const char* Order_Name(Order aOrder) {
+    switch (aOrder) {
+        case Order::Relaxed:
+            return "relaxed";
+        case Order::AcqRel:
+            return "acq_rel";
+        default:
+            return "seq_cst";
+    }
+}
+
+// The strongest order each kind of access may use, for the requested order
+constexpr std::memory_order Load_Order(Order aOrder) {
+    switch (aOrder) {
+        case Order::Relaxed:
+            return std::memory_order::relaxed;
+        case Order::AcqRel:
+            return std::memory_order::acquire;
+        default:
+            return std::memory_order::seq_cst;
+    }
+}
+
+constexpr std::memory_order Store_Order(Order aOrder) {
+    switch (aOrder) {
+        case Order::Relaxed:
+            return std::memory_order::relaxed;
+        case Order::AcqRel:
+            return std::memory_order::release;
+        default:
+            return std::memory_order::seq_cst;
+    }
+}
+
+constexpr std::memory_order Rmw_Order(Order aOrder) {
+    switch (aOrder) {
+        case Order::Relaxed:
+            return std::memory_order::relaxed;
+        case Order::AcqRel:
+            return std::memory_order::acq_rel;
+        default:
+            return std::memory_order::seq_cst;
+    }
+}
+
+using Counter = std::atomic<std::uint64_t>;
+
+// Operation and order are template parameters: a runtime memory order is compiled as seq_cst
+template <Operation Op, Order MemoryOrder>
+void Run_Ops(Counter& aCounter, std::uint64_t aNumOps) {
+    static constexpr auto sLoadOrder  = Load_Order(MemoryOrder);
+    static constexpr auto sStoreOrder = Store_Order(MemoryOrder);
+    static constexpr auto sRmwOrder   = Rmw_Order(MemoryOrder);
+
+    for (std::uint64_t cOp = 0; cOp < aNumOps; ++cOp) {
+        if constexpr (Op == Operation::FetchAdd)
+            aCounter.fetch_add(1, sRmwOrder);
+        else if constexpr (Op == Operation::CasLoop) {
+            auto cValue = aCounter.load(std::memory_order::relaxed);
+            while (!aCounter.compare_exchange_weak(cValue, cValue + 1, sRmwOrder,
+                                                   std::memory_order::relaxed))
+                ;
+        } else if constexpr (Op == Operation::Store)
+            aCounter.store(cOp, sStoreOrder);
+        else
+            aCounter.store(aCounter.load(sLoadOrder) + 1, sStoreOrder);
+    }
+}
+
+using OpsFunction = void (*)(Counter&, std::uint64_t);
+
+template <Operation Op>
+OpsFunction Select_Ops(Order aOrder) {
+    switch (aOrder) {
+        case Order::Relaxed:
+            return Run_Ops<Op, Order::Relaxed>;
+        case Order::AcqRel:
+            return Run_Ops<Op, Order::AcqRel>;
+        default:
+            return Run_Ops<Op, Order::SeqCst>;
+    }
+}
+
+OpsFunction Select_Ops(Operation aOperation, Order aOrder) {
+    switch (aOperation) {
+        case Operation::FetchAdd:
+            return Select_Ops<Operation::FetchAdd>(aOrder);
+        case Operation::CasLoop:
+            return Select_Ops<Operation::CasLoop>(aOrder);
+        case Operation::Store:
+            return Select_Ops<Operation::Store>(aOrder);
+        default:
+            return Select_Ops<Operation::Increment>(aOrder);
+    }
+}
+
+// One counter per thread, aStride bytes apart, starting at a page boundary (so that a stride of
+// a cache line really is one line per thread). Stride 0: a single counter for all threads.
+class CounterBlock {
+    static constexpr std::size_t sPageSize = 4096;
+
+  public:
+    CounterBlock(int aNumThreads, int aStride) : mStride(aStride) {
+        mNumCounters   = (aStride == 0) ? 1 : aNumThreads;
+        auto cSpacing  = std::max<std::size_t>(aStride, sizeof(Counter));
+        auto cNumBytes = mNumCounters * cSpacing;
+        cNumBytes      = (cNumBytes + sPageSize - 1) / sPageSize * sPageSize;
+
+        mStorage = static_cast<std::byte*>(std::aligned_alloc(sPageSize, cNumBytes));
+        if (mStorage == nullptr)
+            throw std::bad_alloc();
+        for (int cCounter = 0; cCounter < mNumCounters; ++cCounter)
+            new (mStorage + cCounter * mStride) Counter(0);
+    }
+    ~CounterBlock() { std::free(mStorage); }
+
+    CounterBlock(const CounterBlock&)            = delete;
+    CounterBlock& operator=(const CounterBlock&) = delete;
+
+    Counter& operator[](int aThread) {
+        return *std::launder(reinterpret_cast<Counter*>(mStorage + aThread * mStride));
+    }
+
+    std::uint64_t Total() {
+        std::uint64_t cTotal = 0;
+        for (int cCounter = 0; cCounter < mNumCounters; ++cCounter)
+            cTotal += (*this)[cCounter].load(std::memory_order::relaxed);
+        return cTotal;
+    }
+
+  private:
+    std::byte* mStorage     = nullptr;
+    int        mStride      = 0;
+    int        mNumCounters = 0;
+};
+
+struct Options {
+    std::vector<int>                 threads;
+    std::vector<int>                 strides     = {0, 8, 64, 128, 256};
+    std::vector<Operation>           operations  = {Operation::FetchAdd};
+    std::vector<Order>               orders      = {Order::Relaxed};
+    std::vector<hw_utils::Placement> placements  = {hw_utils::Placement::None};
+    std::uint64_t                    ops         = 1 << 22;  // Per thread
+    int                              warmup      = 1;
+    int                              repetitions = 5;
+    Format                           format      = Format::Table;
+};
+
+struct Config {
+    int                 threads;
+    int                 stride;
+    Operation           operation;
+    Order               order;
+    hw_utils::Placement placement;
+};
+
+using EventsPerOp = std::array<std::optional<double>, hw_utils::sNumPerfEvents>;
+
+struct Result {
+    double      median_ms   = 0;
+    double      stddev_ms   = 0;
+    double      ops_per_sec = 0;
+    EventsPerOp events_per_op;  // Over all timed repetitions. Empty: unavailable.
+};
+
+// Times one run, from releasing the (already started) threads to joining them, in seconds
+double Run_Once(const Config& aConfig, std::uint64_t aNumOps, hw_utils::PerfCounters& aCounters,
+                hw_utils::PerfSample& aSample) {
+    CounterBlock      cCounters(aConfig.threads, aConfig.stride);
+    auto              cOps  = Select_Ops(aConfig.operation, aConfig.order);
+    auto              cCpus = hw_utils::Placement_Cpus(aConfig.placement, aConfig.threads);
+    std::atomic<int>  cNumReady{0};
+    std::atomic<bool> cGo{false};
+    std::atomic<bool> cPinned{true};
+
+    std::vector<std::thread> cThreads;
+    for (int cThread = 0; cThread < aConfig.threads; ++cThread) {
+        cThreads.emplace_back([&, cThread]() {
+            if (!hw_utils::Pin_This_Thread(cCpus, cThread))
+                cPinned.store(false, std::memory_order::relaxed);
+            cNumReady.fetch_add(1, std::memory_order::release);
+            while (!cGo.load(std::memory_order::acquire))
+                std::this_thread::yield();
+            cOps(cCounters[cThread], aNumOps);
+        });
+    }
+    while (cNumReady.load(std::memory_order::acquire) < aConfig.threads)
+        std::this_thread::yield();
+
+    aCounters.Start();
+    auto cStart = std::chrono::steady_clock::now();
+    cGo.store(true, std::memory_order::release);
+    for (auto& cThread : cThreads)
+        cThread.join();
+    auto cElapsed = std::chrono::steady_clock::now() - cStart;
+    aSample       = aCounters.Stop();
+
+    if (!cPinned.load(std::memory_order::relaxed))
+        throw std::runtime_error("Can't pin the threads");
+
+    // Read-modify-writes must not lose counts, shared or not
+    auto cExpected = aNumOps * aConfig.threads;
+    auto cIsRmw    = (aConfig.operation == Operation::FetchAdd) ||
+                  (aConfig.operation == Operation::CasLoop);
+    if (cIsRmw && (cCounters.Total() != cExpected))
+        throw std::runtime_error("Lost updates: " + std::to_string(cCounters.Total()) + " of " +
+                                 std::to_string(cExpected));
+
+    return std::chrono::duration<double>(cElapsed).count();
+}
+
+Result Run_Config(const Config& aConfig, const Options& aOptions) {
+    // Created first, so they also count the worker threads (once joined)
+    hw_utils::PerfCounters cCounters;
+    hw_utils::PerfSample   cSample;
+
+    for (int cWarmup = 0; cWarmup < aOptions.warmup; ++cWarmup)
+        Run_Once(aConfig, aOptions.ops, cCounters, cSample);
+
+    std::vector<double> cSeconds;
+    EventsPerOp         cEventTotals;
+    for (int cRepetition = 0; cRepetition < aOptions.repetitions; ++cRepetition) {
+        cSeconds.push_back(Run_Once(aConfig, aOptions.ops, cCounters, cSample));
+        for (std::size_t cEvent = 0; cEvent < hw_utils::sNumPerfEvents; ++cEvent) {
+            if (auto cValue = cSample.Get(static_cast<hw_utils::PerfEvent>(cEvent)))
+                cEventTotals[cEvent] = cEventTotals[cEvent].value_or(0) + *cValue;
+        }
+    }
+
+    auto cSorted = cSeconds;
+    std::sort(cSorted.begin(), cSorted.end());
+    auto cMiddle = cSorted.size() / 2;
+    auto cMedian = (cSorted.size() % 2 == 1) ? cSorted[cMiddle]
+                                             : (cSorted[cMiddle - 1] + cSorted[cMiddle]) / 2;
+
+    double cMean = 0;
+    for (auto cValue : cSeconds)
+        cMean += cValue / cSeconds.size();
+    double cVariance = 0;
+    for (auto cValue : cSeconds)
+        cVariance += (cValue - cMean) * (cValue - cMean);
+    if (cSeconds.size() > 1)
+        cVariance /= (cSeconds.size() - 1);
+
+    auto   cOpsPerRun = static_cast<double>(aOptions.ops) * aConfig.threads;
+    Result cResult;
+    cResult.median_ms   = cMedian * 1e3;
+    cResult.stddev_ms   = std::sqrt(cVariance) * 1e3;
+    cResult.ops_per_sec = cOpsPerRun / cMedian;
+
+    auto cTotalOps = cOpsPerRun * aOptions.repetitions;
+    for (std::size_t cEvent = 0; cEvent < hw_utils::sNumPerfEvents; ++cEvent) {
+        if (cEventTotals[cEvent])
+            cResult.events_per_op[cEvent] = *cEventTotals[cEvent] / cTotalOps;
+    }
+    return cResult;
+}
+
+// Output: rows are printed as each configuration finishes
+void Print_Header(const Options& aOptions) {
+    switch (aOptions.format) {
+        case Format::Table:
+            std::printf("%7s %6s %-9s %-7s %-9s %11s %11s %14s  %s\n", "threads", "stride", "op",
+                        "order", "placement", "median_ms", "stddev_ms", "ops_per_sec", "events/op");
+            break;
+        case Format::Csv:
+            std::printf("threads,stride,op,order,placement,ops_per_thread,repetitions,median_ms,"
+                        "stddev_ms,ops_per_sec");
+            for (std::size_t cEvent = 0; cEvent < hw_utils::sNumPerfEvents; ++cEvent)
+                std::printf(",%s_per_op", hw_utils::Perf_Event_Name(hw_utils::PerfEvent(cEvent)));
+            std::printf("\n");
+            break;
+        case Format::Json:
+            std::printf("{\n  \"ops_per_thread\": %llu,\n  \"repetitions\": %d,\n  \"results\": [",
+                        static_cast<unsigned long long>(aOptions.ops), aOptions.repetitions);
+            break;
+    }
+}
+
+void Print_Result(const Options& aOptions, const Config& aConfig, const Result& aResult,
+                  bool aIsFirst) {
+    auto cOp        = Operation_Name(aConfig.operation);
+    auto cOrder     = Order_Name(aConfig.order);
+    auto cPlacement = hw_utils::Placement_Name(aConfig.placement);
+    auto cName      = [](std::size_t aEvent) {
+        return hw_utils::Perf_Event_Name(static_cast<hw_utils::PerfEvent>(aEvent));
+    };
+
+    switch (aOptions.format) {
+        case Format::Table:
+            std::printf("%7d %6d %-9s %-7s %-9s %11.2f %11.2f %14.0f", aConfig.threads,
+                        aConfig.stride, cOp, cOrder, cPlacement, aResult.median_ms,
+                        aResult.stddev_ms, aResult.ops_per_sec);
+            for (std::size_t cEvent = 0; cEvent < hw_utils::sNumPerfEvents; ++cEvent) {
+                if (auto cValue = aResult.events_per_op[cEvent])
+                    std::printf("  %s=%.3f", cName(cEvent), *cValue);
+            }
+            std::printf("\n");
+            break;
+        case Format::Csv:
+            std::printf("%d,%d,%s,%s,%s,%llu,%d,%.3f,%.3f,%.0f", aConfig.threads, aConfig.stride,
+                        cOp, cOrder, cPlacement, static_cast<unsigned long long>(aOptions.ops),
+                        aOptions.repetitions, aResult.median_ms, aResult.stddev_ms,
+                        aResult.ops_per_sec);
+            for (auto& cValue : aResult.events_per_op) {
+                if (cValue)
+                    std::printf(",%.4f", *cValue);
+                else
+                    std::printf(",");
+            }
+            std::printf("\n");
+            break;
+        case Format::Json:
+            std::printf("%s\n    {\"threads\": %d, \"stride\": %d, ", aIsFirst ? "" : ",",
+                        aConfig.threads, aConfig.stride);
+            std::printf("\"op\": \"%s\", \"order\": \"%s\", \"placement\": \"%s\", ", cOp, cOrder,
+                        cPlacement);
+            std::printf("\"median_ms\": %.3f, \"stddev_ms\": %.3f, \"ops_per_sec\": %.0f",
+                        aResult.median_ms, aResult.stddev_ms, aResult.ops_per_sec);
+            for (std::size_t cEvent = 0; cEvent < hw_utils::sNumPerfEvents; ++cEvent) {
+                if (auto cValue = aResult.events_per_op[cEvent])
+                    std::printf(", \"%s_per_op\": %.4f", cName(cEvent), *cValue);
+            }
+            std::printf("}");
+            break;
+    }
+    std::fflush(stdout);
+}
+
+void Print_Footer(const Options& aOptions) {
+    if (aOptions.format == Format::Json)
+        std::printf("\n  ]\n}\n");
+}
+
+// Command line
+std::vector<std::string_view> Split(std::string_view aList) {
+    std::vector<std::string_view> cItems;
+    while (true) {
+        auto cComma = aList.find(',');
+        cItems.push_back(aList.substr(0, cComma));
+        if (cComma == std::string_view::npos)
+            return cItems;
+        aList.remove_prefix(cComma + 1);
+    }
+}
+
+std::uint64_t Parse_Number(std::string_view aText, std::string_view aOption) {
+    std::uint64_t cValue = 0;
+    auto [cEnd, cError]  = std::from_chars(aText.data(), aText.data() + aText.size(), cValue);
+    if ((cError != std::errc()) || (cEnd != aText.data() + aText.size()))
+        throw std::invalid_argument("Invalid --" + std::string(aOption) + " value: " +
+                                    std::string(aText));
+    return cValue;
+}
+
+Operation Parse_Operation(std::string_view aText) {
+    for (auto cOperation : {Operation::FetchAdd, Operation::CasLoop, Operation::Store,
+                            Operation::Increment}) {
+        if (aText == Operation_Name(cOperation))
+            return cOperation;
+    }
+    throw std::invalid_argument("Unknown --op: " + std::string(aText));
+}
+
+Order Parse_Order(std::string_view aText) {
+    for (auto cOrder : {Order::Relaxed, Order::AcqRel, Order::SeqCst}) {
+        if (aText == Order_Name(cOrder))
+            return cOrder;
+    }
+    throw std::invalid_argument("Unknown --order: " + std::string(aText));
+}
+
+hw_utils::Placement Parse_Placement(std::string_view aText) {
+    if (auto cPlacement = hw_utils::Parse_Placement(aText))
+        return *cPlacement;
+    throw std::invalid_argument("Unknown --placement: " + std::string(aText));
+}
+
+Format Parse_Format(std::string_view aText) {
+    if (aText == "table")
+        return Format::Table;
+    if (aText == "csv")
+        return Format::Csv;
+    if (aText == "json")
+        return Format::Json;
+    throw std::invalid_argument("Unknown --format: " + std::string(aText));
+}
+
+// Powers of two up to the number of CPUs (and at least 2, for some contention)
+std::vector<int> Default_Threads() {
+    auto             cNumCpus = std::max(2, static_cast<int>(std::thread::hardware_concurrency()));
+    std::vector<int> cThreads;
+    for (int cCount = 1; cCount < cNumCpus; cCount *= 2)
+        cThreads.push_back(cCount);
+    cThreads.push_back(cNumCpus);
+    return cThreads;
+}
+
+Options Parse_Options(int aArgc, char** aArgv) {
+    Options cOptions;
+    cOptions.threads = Default_Threads();
+
+    for (int cArg = 1; cArg < aArgc; ++cArg) {
+        std::string_view cText = aArgv[cArg];
+        auto             cEquals = cText.find('=');
+        if (!cText.starts_with("--") || (cEquals == std::string_view::npos))
+            throw std::invalid_argument("Expected --option=value, got: " + std::string(cText));
+        auto cOption = cText.substr(2, cEquals - 2);
+        auto cValue  = cText.substr(cEquals + 1);
+
+        if (cOption == "threads" || cOption == "stride") {
+            auto& cList = (cOption == "threads") ? cOptions.threads : cOptions.strides;
+            cList.clear();
+            for (auto cItem : Split(cValue))
+                cList.push_back(static_cast<int>(Parse_Number(cItem, cOption)));
+        } else if (cOption == "op") {
+            cOptions.operations.clear();
+            for (auto cItem : Split(cValue))
+                cOptions.operations.push_back(Parse_Operation(cItem));
+        } else if (cOption == "order") {
+            cOptions.orders.clear();
+            for (auto cItem : Split(cValue))
+                cOptions.orders.push_back(Parse_Order(cItem));
+        } else if (cOption == "placement") {
+            cOptions.placements.clear();
+            for (auto cItem : Split(cValue))
+                cOptions.placements.push_back(Parse_Placement(cItem));
+        } else if (cOption == "ops")
+            cOptions.ops = Parse_Number(cValue, cOption);
+        else if (cOption == "warmup")
+            cOptions.warmup = static_cast<int>(Parse_Number(cValue, cOption));
+        else if (cOption == "repetitions")
+            cOptions.repetitions = static_cast<int>(Parse_Number(cValue, cOption));
+        else if (cOption == "format")
+            cOptions.format = Parse_Format(cValue);
+        else
+            throw std::invalid_argument("Unknown option: --" + std::string(cOption));
+    }
+
+    for (auto cThreads : cOptions.threads) {
+        if (cThreads < 1)
+            throw std::invalid_argument("--threads must be at least 1");
+    }
+    for (auto cStride : cOptions.strides) {
+        if (cStride % sizeof(Counter) != 0)
+            throw std::invalid_argument("--stride must be a multiple of 8: " +
+                                        std::to_string(cStride));
+    }
+    if ((cOptions.repetitions < 1) || (cOptions.ops == 0))
+        throw std::invalid_argument("--repetitions and --ops must be at least 1");
+    return cOptions;
+}
+
+}  // namespace false_sharing_example
+
+int main(int argc, char** argv) {
+    using namespace false_sharing_example;
+
+    Options options;
+    try {
+        options = Parse_Options(argc, argv);
+    } catch (const std::invalid_argument& error) {
+        std::fprintf(stderr,
+                     "%s\nUsage: %s [--threads=1,2,4] [--stride=0,8,64,128,256] "
+                     "[--op=fetch_add,cas,store,increment] [--order=relaxed,acq_rel,seq_cst] "
+                     "[--placement=none,compact,cores,spread] [--ops=N] [--warmup=N] "
+                     "[--repetitions=N] [--format=table|csv|json]\n",
+                     error.what(), argv[0]);
+        return 1;
+    }
+
+    // The machine the curves belong to
+    auto& topology = hw_utils::System_Topology();
+    std::fprintf(stderr,
+                 "Cache line %zu B, L1d %zu KiB, L2 %zu KiB, LLC %zu KiB; %d CPUs, %d cores, "
+                 "%d packages, %d NUMA nodes\n",
+                 topology.cache_line_size, topology.l1d_size >> 10, topology.l2_size >> 10,
+                 topology.llc_size >> 10, topology.num_cpus, topology.num_cores,
+                 topology.num_packages, topology.num_nodes);
+    if (!hw_utils::Padding_Covers_Cache_Line())
+        std::fprintf(stderr, "Cache lines are larger than the %zu byte padding\n",
+                     hw_utils::sFalseSharingPadding);
+    if (hw_utils::Allowed_Cpus().empty())
+        std::fprintf(stderr, "Thread pinning unsupported: every placement runs unpinned\n");
+    if (!hw_utils::PerfCounters().Any_Available())
+        std::fprintf(stderr, "Hardware counters unavailable: reporting wall time only\n");
+
+    // A configuration that fails (can't pin, lost updates) is reported on stderr and skipped, so
+    // the document on stdout stays complete
+    Print_Header(options);
+    bool isFirst   = true;
+    bool hasFailed = false;
+    for (auto operation : options.operations) {
+        for (auto order : options.orders) {
+            for (auto placement : options.placements) {
+                for (auto stride : options.strides) {
+                    for (auto threads : options.threads) {
+                        Config config = {threads, stride, operation, order, placement};
+                        try {
+                            Print_Result(options, config, Run_Config(config, options), isFirst);
+                            isFirst = false;
+                        } catch (const std::exception& error) {
+                            std::fprintf(stderr,
+                                         "Failed: threads=%d stride=%d op=%s order=%s "
+                                         "placement=%s: %s\n",
+                                         threads, stride, Operation_Name(operation),
+                                         Order_Name(order), hw_utils::Placement_Name(placement),
+                                         error.what());
+                            hasFailed = true;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    Print_Footer(options);
+    return hasFailed ? 1 : 0;
+}
@@ -0,0 +1,127 @@
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "Affinity.hpp"
+#include "ShardedCounter.hpp"
+
+// Scaling of ShardedCounter against direct-share.cpp's single atomic: every thread increments the
+// same logical counter, for 1, 2, 4... up to --max-threads threads (default 64). Reports the
+// median of --repetitions runs (default 3) of --ops increments per thread (default 2^20), with the
+// threads pinned per --placement (default none; see driver.cpp).
+namespace false_sharing_example {
+
+// direct-share.cpp's counter, with the ShardedCounter interface
+class SingleAtomicCounter {
+  public:
+    void         Increment() { mValue.fetch_add(1, std::memory_order::relaxed); }
+    std::int64_t read() const { return mValue.load(std::memory_order::relaxed); }
+
+  private:
+    std::atomic<std::int64_t> mValue{0};
+};
+
+// Median wall time in milliseconds
+template <typename CounterType>
+double Time_Counter(int aNumThreads, std::int64_t aNumOps, int aRepetitions,
+                    hw_utils::Placement aPlacement) {
+    auto                cCpus = hw_utils::Placement_Cpus(aPlacement, aNumThreads);
+    std::vector<double> cMilliseconds;
+    for (int cRepetition = 0; cRepetition < aRepetitions; ++cRepetition) {
+        CounterType       cCounter;
+        std::atomic<bool> cGo{false};
+
+        std::vector<std::thread> cThreads;
+        for (int cThread = 0; cThread < aNumThreads; ++cThread) {
+            cThreads.emplace_back([&, cThread]() {
+                hw_utils::Pin_This_Thread(cCpus, cThread);
+                while (!cGo.load(std::memory_order::acquire))
+                    std::this_thread::yield();
+                for (std::int64_t cOp = 0; cOp < aNumOps; ++cOp)
+                    cCounter.Increment();
+            });
+        }
+
+        auto cStart = std::chrono::steady_clock::now();
+        cGo.store(true, std::memory_order::release);
+        for (auto& cThread : cThreads)
+            cThread.join();
+        auto cElapsed = std::chrono::steady_clock::now() - cStart;
+
+        if (cCounter.read() != aNumOps * aNumThreads) {
+            std::fprintf(stderr, "Lost increments: %lld of %lld\n",
+                         static_cast<long long>(cCounter.read()),
+                         static_cast<long long>(aNumOps * aNumThreads));
+            std::exit(1);
+        }
+        cMilliseconds.push_back(std::chrono::duration<double, std::milli>(cElapsed).count());
+    }
+
+    std::sort(cMilliseconds.begin(), cMilliseconds.end());
+    return cMilliseconds[cMilliseconds.size() / 2];
+}
+
+}  // namespace false_sharing_example
+
+int main(int argc, char** argv) {
+    using namespace false_sharing_example;
+
+    std::int64_t maxThreads  = 64;
+    std::int64_t numOps      = 1 << 20;
+    std::int64_t repetitions = 3;
+    auto         placement   = hw_utils::Placement::None;
+    for (int arg = 1; arg < argc; ++arg) {
+        std::string_view text   = argv[arg];
+        auto             equals = text.find('=');
+        auto             name   = text.substr(0, equals);
+        auto             value  = text.substr(equals + 1);
+
+        auto parsed = hw_utils::Parse_Placement(value);
+        if ((name == "--placement") && parsed && (equals != std::string_view::npos)) {
+            placement = *parsed;
+            continue;
+        }
+
+        std::int64_t* target = nullptr;
+        if (name == "--max-threads")
+            target = &maxThreads;
+        else if (name == "--ops")
+            target = &numOps;
+        else if (name == "--repetitions")
+            target = &repetitions;
+
+        auto error = std::errc::invalid_argument;
+        if ((target != nullptr) && (equals != std::string_view::npos))
+            error = std::from_chars(value.data(), value.data() + value.size(), *target).ec;
+        if ((error != std::errc()) || (*target < 1)) {
+            std::fprintf(stderr,
+                         "Usage: %s [--max-threads=64] [--ops=N] [--repetitions=N] "
+                         "[--placement=none|compact|cores|spread]\n",
+                         argv[0]);
+            return 1;
+        }
+    }
+
+    using PerThreadCounter = ShardedCounter<ShardSelection::PerThread>;
+    using PerCpuCounter    = ShardedCounter<ShardSelection::PerCpu>;
+
+    auto reps = static_cast<int>(repetitions);
+    std::printf("%7s %14s %14s %14s %14s %14s\n", "threads", "single_ms", "per_thread_ms",
+                "per_cpu_ms", "per_thread_x", "per_cpu_x");
+    for (int threads = 1; threads <= maxThreads; threads *= 2) {
+        auto single    = Time_Counter<SingleAtomicCounter>(threads, numOps, reps, placement);
+        auto perThread = Time_Counter<PerThreadCounter>(threads, numOps, reps, placement);
+        auto perCpu    = Time_Counter<PerCpuCounter>(threads, numOps, reps, placement);
+        std::printf("%7d %14.2f %14.2f %14.2f %14.2f %14.2f\n", threads, single, perThread,
+                    perCpu, single / perThread, single / perCpu);
+        std::fflush(stdout);
+    }
+    return 0;
+}
@@ -1,63 +1,58 @@
-
 #!/bin/bash
 set -e
 
 mkdir -p build
 
 CXX="g++"
-CXXFLAGS="-std=c++20 -pthread -O3 -Wall -Wextra -Wno-unknown-warning-option -Wno-interference-size"
+CXXFLAGS="-std=c++20 -pthread -O3 -Wall -Wextra"
 
-sources=("secuencial.cpp" "direct-share.cpp" "false-share.cpp" "no-share.cpp")
+examples=("secuencial" "direct-share" "false-share" "no-share")
+sources=("${examples[@]/%/.cpp}" "driver.cpp" "sharded-counter.cpp")
 
 for src in "${sources[@]}"; do
     exe="${src%.cpp}"
     echo "Building $exe..."
-    $CXX $CXXFLAGS -o "build/$exe" "$src"
+    $CXX $CXXFLAGS -I../hw-utils -o "build/$exe" "$src"
 done
 
-echo "Measuring execution time..."
-
-if [[ "$OSTYPE" == "darwin"* ]]; then
-    # macOS: use hyperfine
-    if ! command -v hyperfine &> /dev/null; then
-        echo "hyperfine not found. Please install it with 'brew install hyperfine'."
-        exit 1
-    fi
-
-    cmd="hyperfine --warmup 5 --runs 5"
-    for src in "${sources[@]}"; do
-        exe="${src%.cpp}"
-        cmd+=" ./build/$exe"
-    done
-    eval "$cmd"
+# The four fixed examples, timed with the shell's time (portable: no hyperfine or GNU time needed)
+TIMEFORMAT="  Elapsed: %3R s   User: %3U s   System: %3S s"
+for exe in "${examples[@]}"; do
+    echo "Running $exe..."
+    time "./build/$exe"
+done
 
+# Contention sweep: threads x stride x op, measured in-process (median/stddev over repetitions,
+# plus hardware counters where available). Override with e.g. THREADS=1,2,4,8,16 ./test.sh
+# PLACEMENTS pins the threads (none,compact,cores,spread; Linux only: elsewhere threads run
+# unpinned, and there are no hardware counters). MAX_THREADS bounds the sharded counter comparison.
+THREADS="${THREADS:-1,2,4,8}"
+STRIDES="${STRIDES:-0,8,64,128,256}"
+OPS="${OPS:-fetch_add,cas,store,increment}"
+ORDERS="${ORDERS:-relaxed}"
+PLACEMENTS="${PLACEMENTS:-none}"
+OPS_PER_THREAD="${OPS_PER_THREAD:-1048576}"
+REPETITIONS="${REPETITIONS:-5}"
+
+args=(--threads="$THREADS" --stride="$STRIDES" --op="$OPS" --order="$ORDERS"
+      --placement="$PLACEMENTS" --ops="$OPS_PER_THREAD" --repetitions="$REPETITIONS")
+
+# A failed configuration is left out of the CSV: show the rest, then fail
+echo "Running contention sweep..."
+sweep_status=0
+./build/driver "${args[@]}" --format=csv > build/driver.csv || sweep_status=$?
+if command -v column &> /dev/null; then
+    column -s, -t < build/driver.csv
 else
-    # Linux: use time with readable format
-    for src in "${sources[@]}"; do
-        exe="${src%.cpp}"
-        echo "Benchmarking $exe..."
-        
-        # Run the program and capture timing info
-        output=$(/usr/bin/time -f "TIMING_DATA: %e %U %S %P %M" "./build/$exe" 2>&1)
-        
-        # Extract program output (everything before TIMING_DATA)
-        program_output=$(echo "$output" | grep -v "TIMING_DATA:")
-        echo "$program_output"
-        
-        # Extract and format timing data
-        timing_line=$(echo "$output" | grep "TIMING_DATA:" | sed 's/TIMING_DATA: //')
-        read elapsed user system cpu_percent memory <<< "$timing_line"
-        
-        # Convert to milliseconds for better readability
-        elapsed_ms=$(echo "$elapsed * 1000" | bc -l 2>/dev/null || echo "scale=1; $elapsed * 1000" | bc)
-        user_ms=$(echo "$user * 1000" | bc -l 2>/dev/null || echo "scale=1; $user * 1000" | bc)
-        system_ms=$(echo "$system * 1000" | bc -l 2>/dev/null || echo "scale=1; $system * 1000" | bc)
-        
-        printf "  Elapsed time: %8.1f ms\n" "$elapsed_ms"
-        printf "  CPU time:     %8.1f ms (user: %.1f ms, system: %.1f ms)\n" \
-               "$(echo "$user_ms + $system_ms" | bc)" "$user_ms" "$system_ms"
-        printf "  CPU usage:    %8s%%\n" "$cpu_percent"
-        printf "  Memory:       %8s KB\n\n" "$memory"
-    done
+    cat build/driver.csv
 fi
-echo "Build complete."
\ No newline at end of file
+
+echo "Results written to build/driver.csv"
+if [ "$sweep_status" -ne 0 ]; then
+    echo "Contention sweep failed for some configurations (see above)"
+    exit "$sweep_status"
+fi
+
+echo "Running sharded counter scaling..."
+./build/sharded-counter --max-threads="${MAX_THREADS:-64}" --ops="$OPS_PER_THREAD"
+echo "Build complete."
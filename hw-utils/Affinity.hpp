@@ -0,0 +1,183 @@
+#pragma once
+
+#include <algorithm>
+#include <map>
+#include <optional>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+    #include <pthread.h>
+    #include <sched.h>
+#endif
+
+#include "Topology.hpp"
+
+// Thread placement for reproducible benchmarks: which CPU each thread (by index) is pinned to,
+// from the topology of the CPUs this process may run on. Pinning is Linux only: elsewhere every
+// placement leaves the threads to the scheduler.
+namespace hw_utils {
+
+enum class Placement {
+    None,     // Not pinned: the scheduler decides, and may migrate threads
+    Compact,  // Fill a core's SMT siblings before the next core: threads 0 and 1 share a core
+    Cores,    // One thread per physical core, one socket at a time, then the SMT siblings
+    Spread    // One thread per core, round-robin across sockets: threads 0 and 1 cross sockets
+};
+
+constexpr Placement sPlacements[] = {Placement::None, Placement::Compact, Placement::Cores,
+                                     Placement::Spread};
+
+constexpr const char* Placement_Name(Placement aPlacement) {
+    switch (aPlacement) {
+        case Placement::Compact:
+            return "compact";
+        case Placement::Cores:
+            return "cores";
+        case Placement::Spread:
+            return "spread";
+        default:
+            return "none";
+    }
+}
+
+inline std::optional<Placement> Parse_Placement(std::string_view aName) {
+    for (auto cPlacement : sPlacements) {
+        if (aName == Placement_Name(cPlacement))
+            return cPlacement;
+    }
+    return std::nullopt;
+}
+
+// What two CPUs share
+enum class CpuRelation { Same, SmtSiblings, SameSocket, CrossSocket };
+
+constexpr const char* Relation_Name(CpuRelation aRelation) {
+    switch (aRelation) {
+        case CpuRelation::Same:
+            return "same_cpu";
+        case CpuRelation::SmtSiblings:
+            return "smt_siblings";
+        case CpuRelation::SameSocket:
+            return "same_socket";
+        default:
+            return "cross_socket";
+    }
+}
+
+inline CpuRelation Relation(const CpuLocation& aFirst, const CpuLocation& aSecond) {
+    if (aFirst.cpu == aSecond.cpu)
+        return CpuRelation::Same;
+    if (aFirst.package != aSecond.package)
+        return CpuRelation::CrossSocket;
+    return (aFirst.core == aSecond.core) ? CpuRelation::SmtSiblings : CpuRelation::SameSocket;
+}
+
+// The online CPUs this process may run on. Empty where pinning isn't supported.
+inline std::vector<CpuLocation> Allowed_Cpus() {
+    std::vector<CpuLocation> cCpus;
+#if defined(__linux__)
+    cpu_set_t cAllowed;
+    CPU_ZERO(&cAllowed);
+    if (sched_getaffinity(0, sizeof(cAllowed), &cAllowed) != 0)
+        return cCpus;
+    for (auto& cCpu : System_Topology().cpus) {
+        if ((cCpu.cpu < CPU_SETSIZE) && CPU_ISSET(cCpu.cpu, &cAllowed))
+            cCpus.push_back(cCpu);
+    }
+#endif
+    return cCpus;
+}
+
+// The CPU for each of aNumThreads threads, in thread order. With more threads than CPUs, CPUs are
+// reused in the same order. Empty for Placement::None, or where pinning isn't supported.
+inline std::vector<CpuLocation> Placement_Cpus(Placement aPlacement, int aNumThreads) {
+    auto cCpus = Allowed_Cpus();
+    if ((aPlacement == Placement::None) || cCpus.empty())
+        return {};
+
+    // Rank of each CPU among its core's SMT siblings, and of each core within its package
+    std::sort(cCpus.begin(), cCpus.end(), [](auto& aFirst, auto& aSecond) {
+        return std::tie(aFirst.package, aFirst.core, aFirst.cpu) <
+               std::tie(aSecond.package, aSecond.core, aSecond.cpu);
+    });
+    std::map<std::pair<int, int>, int> cCoreRanks;   // (package, core) -> rank in package
+    std::map<std::pair<int, int>, int> cSmtCounts;   // (package, core) -> siblings seen
+    std::map<int, int>                 cCoreCounts;  // package -> cores seen
+    std::map<int, std::pair<int, int>> cRanks;       // cpu -> (smt rank, core rank)
+    for (auto& cCpu : cCpus) {
+        auto cCore = std::make_pair(cCpu.package, cCpu.core);
+        if (!cCoreRanks.contains(cCore))
+            cCoreRanks[cCore] = cCoreCounts[cCpu.package]++;
+        cRanks[cCpu.cpu] = {cSmtCounts[cCore]++, cCoreRanks[cCore]};
+    }
+
+    auto cKey = [&](const CpuLocation& aCpu) {
+        auto [cSmtRank, cCoreRank] = cRanks[aCpu.cpu];
+        switch (aPlacement) {
+            case Placement::Compact:
+                return std::make_tuple(aCpu.package, aCpu.core, cSmtRank);
+            case Placement::Cores:
+                return std::make_tuple(cSmtRank, aCpu.package, cCoreRank);
+            default:
+                return std::make_tuple(cSmtRank, cCoreRank, aCpu.package);
+        }
+    };
+    std::stable_sort(cCpus.begin(), cCpus.end(),
+                     [&](auto& aFirst, auto& aSecond) { return cKey(aFirst) < cKey(aSecond); });
+
+    std::vector<CpuLocation> cPlaced;
+    for (int cThread = 0; cThread < aNumThreads; ++cThread)
+        cPlaced.push_back(cCpus[cThread % cCpus.size()]);
+    return cPlaced;
+}
+
+// Pins the calling thread to aCpu. False if unsupported or not allowed.
+inline bool Pin_This_Thread([[maybe_unused]] int aCpu) {
+#if defined(__linux__)
+    cpu_set_t cSet;
+    CPU_ZERO(&cSet);
+    CPU_SET(aCpu, &cSet);
+    return pthread_setaffinity_np(pthread_self(), sizeof(cSet), &cSet) == 0;
+#else
+    return false;
+#endif
+}
+
+// Pins the calling thread to the aThread'th CPU of aCpus, if there is one. False if it couldn't.
+inline bool Pin_This_Thread(const std::vector<CpuLocation>& aCpus, int aThread) {
+    if (aCpus.empty())
+        return true;  // Placement::None
+    return Pin_This_Thread(aCpus[aThread % aCpus.size()].cpu);
+}
+
+// Restores the calling thread's CPU affinity when destroyed (e.g. a benchmark's main thread,
+// pinned for one run)
+class ScopedAffinity {
+  public:
+#if defined(__linux__)
+    ScopedAffinity() {
+        CPU_ZERO(&mOriginal);
+        mIsSaved = pthread_getaffinity_np(pthread_self(), sizeof(mOriginal), &mOriginal) == 0;
+    }
+    ~ScopedAffinity() {
+        if (mIsSaved)
+            pthread_setaffinity_np(pthread_self(), sizeof(mOriginal), &mOriginal);
+    }
+#else
+    ScopedAffinity() = default;
+#endif
+
+    ScopedAffinity(const ScopedAffinity&)            = delete;
+    ScopedAffinity& operator=(const ScopedAffinity&) = delete;
+
+  private:
+#if defined(__linux__)
+    cpu_set_t mOriginal;
+    bool      mIsSaved = false;
+#endif
+};
+
+}  // namespace hw_utils
@@ -0,0 +1,253 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <initializer_list>
+#include <optional>
+#include <string>
+
+#if defined(__linux__)
+    #include <linux/perf_event.h>
+    #include <sys/ioctl.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+    #include <cpuid.h>
+#endif
+
+// Hardware performance counters around a region of code, via perf_event_open (no libpfm or perf
+// tool needed). Each event is opened on its own, so an event the CPU, kernel or VM doesn't
+// support is just reported as unavailable: the rest still count. Nothing is available off Linux,
+// in most VMs (no PMU passthrough), or with kernel.perf_event_paranoid > 2.
+//
+// Counts the calling thread, plus (by default) every thread it creates after the counters are
+// constructed: their counts are added when they exit, so join them before Stop().
+namespace hw_utils {
+
+enum class PerfEvent {
+    Cycles = 0,
+    Instructions,
+    BranchMisses,
+    L1dMisses,   // L1 data cache read misses
+    LlcMisses,   // Last level cache misses
+    DtlbMisses,  // Data TLB read misses
+    Hitm,        // Loads hitting a line modified in another core's cache (Intel, or raw override)
+    Count
+};
+
+constexpr std::size_t sNumPerfEvents = static_cast<std::size_t>(PerfEvent::Count);
+
+inline const char* Perf_Event_Name(PerfEvent aEvent) {
+    static constexpr std::array<const char*, sNumPerfEvents> sNames = {
+        "cycles", "instructions", "branch_misses", "l1d_misses", "llc_misses", "dtlb_misses",
+        "hitm"};
+    return sNames[static_cast<std::size_t>(aEvent)];
+}
+
+// Counts of one region. Missing events weren't available.
+class PerfSample {
+  public:
+    std::optional<std::uint64_t> Get(PerfEvent aEvent) const {
+        return mValues[static_cast<std::size_t>(aEvent)];
+    }
+
+    void Set(PerfEvent aEvent, std::uint64_t aValue) {
+        mValues[static_cast<std::size_t>(aEvent)] = aValue;
+    }
+
+    // E.g. "cycles=1234 instructions=5678", unavailable events omitted
+    std::string To_String() const {
+        std::string cText;
+        for (std::size_t cEvent = 0; cEvent < sNumPerfEvents; ++cEvent) {
+            if (!mValues[cEvent])
+                continue;
+            if (!cText.empty())
+                cText += ' ';
+            cText += Perf_Event_Name(static_cast<PerfEvent>(cEvent));
+            cText += '=' + std::to_string(*mValues[cEvent]);
+        }
+        return cText;
+    }
+
+  private:
+    std::array<std::optional<std::uint64_t>, sNumPerfEvents> mValues = {};
+};
+
+class PerfCounters {
+  public:
+    // By default: everything but data TLB misses
+    explicit PerfCounters(std::initializer_list<PerfEvent> aEvents = {PerfEvent::Cycles,
+                                                                      PerfEvent::Instructions,
+                                                                      PerfEvent::BranchMisses,
+                                                                      PerfEvent::L1dMisses,
+                                                                      PerfEvent::LlcMisses,
+                                                                      PerfEvent::Hitm},
+                          bool aCountNewThreads = true) {
+        mFds.fill(-1);
+        for (auto cEvent : aEvents)
+            mFds[static_cast<std::size_t>(cEvent)] = Open(cEvent, aCountNewThreads);
+    }
+
+    ~PerfCounters() {
+#if defined(__linux__)
+        for (auto cFd : mFds) {
+            if (cFd >= 0)
+                close(cFd);
+        }
+#endif
+    }
+
+    PerfCounters(const PerfCounters&)            = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    bool Is_Available(PerfEvent aEvent) const {
+        return mFds[static_cast<std::size_t>(aEvent)] >= 0;
+    }
+
+    bool Any_Available() const {
+        for (auto cFd : mFds) {
+            if (cFd >= 0)
+                return true;
+        }
+        return false;
+    }
+
+    // Zeroes and enables every available counter
+    void Start() {
+#if defined(__linux__)
+        for (auto cFd : mFds) {
+            if (cFd >= 0)
+                ioctl(cFd, PERF_EVENT_IOC_RESET, 0);
+        }
+        for (auto cFd : mFds) {
+            if (cFd >= 0)
+                ioctl(cFd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    // Disables the counters and reads them, scaled up if the kernel had to multiplex them
+    PerfSample Stop() {
+        PerfSample cSample;
+#if defined(__linux__)
+        for (auto cFd : mFds) {
+            if (cFd >= 0)
+                ioctl(cFd, PERF_EVENT_IOC_DISABLE, 0);
+        }
+
+        for (std::size_t cEvent = 0; cEvent < sNumPerfEvents; ++cEvent) {
+            if (mFds[cEvent] < 0)
+                continue;
+
+            // Value, time enabled, time running (PERF_FORMAT_TOTAL_TIME_*)
+            std::array<std::uint64_t, 3> cRead = {};
+            if (read(mFds[cEvent], cRead.data(), sizeof(cRead)) != sizeof(cRead))
+                continue;
+            auto [cValue, cEnabled, cRunning] = cRead;
+            if ((cRunning > 0) && (cRunning < cEnabled)) {
+                auto cScale = static_cast<double>(cEnabled) / static_cast<double>(cRunning);
+                cValue      = static_cast<std::uint64_t>(static_cast<double>(cValue) * cScale);
+            }
+            cSample.Set(static_cast<PerfEvent>(cEvent), cValue);
+        }
+#endif
+        return cSample;
+    }
+
+  private:
+    // Raw event for HITM loads: from HW_UTILS_HITM_EVENT (hex config, e.g. "0x04d2") if set,
+    // else MEM_LOAD_L3_HIT_RETIRED.XSNP_HITM (Skylake and later Intel cores), else none
+    static std::optional<std::uint64_t> Hitm_Config() {
+        if (auto cOverride = std::getenv("HW_UTILS_HITM_EVENT"))
+            return std::strtoull(cOverride, nullptr, 16);
+#if defined(__x86_64__) || defined(__i386__)
+        unsigned int cMaxLeaf = 0, cEbx = 0, cEcx = 0, cEdx = 0;
+        if (__get_cpuid(0, &cMaxLeaf, &cEbx, &cEcx, &cEdx) == 0)
+            return std::nullopt;
+        auto cIsIntel = (cEbx == 0x756e6547) && (cEdx == 0x49656e69) && (cEcx == 0x6c65746e);
+        if (cIsIntel)
+            return 0x04d2;  // Event 0xd2, umask 0x04
+#endif
+        return std::nullopt;
+    }
+
+    static int Open([[maybe_unused]] PerfEvent aEvent, [[maybe_unused]] bool aCountNewThreads) {
+#if defined(__linux__)
+        static constexpr auto sReadMiss =
+            (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+
+        perf_event_attr cAttributes = {};
+        cAttributes.size            = sizeof(cAttributes);
+        cAttributes.disabled        = 1;
+        cAttributes.exclude_kernel  = 1;
+        cAttributes.exclude_hv      = 1;
+        cAttributes.inherit         = aCountNewThreads ? 1 : 0;
+        cAttributes.read_format =
+            PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        switch (aEvent) {
+            case PerfEvent::Cycles:
+                cAttributes.type   = PERF_TYPE_HARDWARE;
+                cAttributes.config = PERF_COUNT_HW_CPU_CYCLES;
+                break;
+            case PerfEvent::Instructions:
+                cAttributes.type   = PERF_TYPE_HARDWARE;
+                cAttributes.config = PERF_COUNT_HW_INSTRUCTIONS;
+                break;
+            case PerfEvent::BranchMisses:
+                cAttributes.type   = PERF_TYPE_HARDWARE;
+                cAttributes.config = PERF_COUNT_HW_BRANCH_MISSES;
+                break;
+            case PerfEvent::L1dMisses:
+                cAttributes.type   = PERF_TYPE_HW_CACHE;
+                cAttributes.config = PERF_COUNT_HW_CACHE_L1D | sReadMiss;
+                break;
+            case PerfEvent::LlcMisses:
+                cAttributes.type   = PERF_TYPE_HARDWARE;
+                cAttributes.config = PERF_COUNT_HW_CACHE_MISSES;
+                break;
+            case PerfEvent::DtlbMisses:
+                cAttributes.type   = PERF_TYPE_HW_CACHE;
+                cAttributes.config = PERF_COUNT_HW_CACHE_DTLB | sReadMiss;
+                break;
+            case PerfEvent::Hitm: {
+                auto cConfig = Hitm_Config();
+                if (!cConfig)
+                    return -1;
+                cAttributes.type   = PERF_TYPE_RAW;
+                cAttributes.config = *cConfig;
+                break;
+            }
+            default:
+                return -1;
+        }
+
+        return static_cast<int>(syscall(SYS_perf_event_open, &cAttributes, 0, -1, -1, 0));
+#else
+        return -1;
+#endif
+    }
+
+    std::array<int, sNumPerfEvents> mFds;  // -1: unavailable
+};
+
+// Counts a scope: starts on construction, and stores the sample on destruction
+class PerfScope {
+  public:
+    PerfScope(PerfCounters& aCounters, PerfSample& aSample)
+        : mCounters(aCounters), mSample(aSample) {
+        mCounters.Start();
+    }
+    ~PerfScope() { mSample = mCounters.Stop(); }
+
+    PerfScope(const PerfScope&)            = delete;
+    PerfScope& operator=(const PerfScope&) = delete;
+
+  private:
+    PerfCounters& mCounters;
+    PerfSample&   mSample;
+};
+
+}  // namespace hw_utils
@@ -0,0 +1,277 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+#if defined(__APPLE__)
+    #include <sys/sysctl.h>
+#endif
+
+// CPU and cache topology, read once from sysfs (Linux) or sysctl (macOS), falling back to
+// sysconf, plus the compile-time padding that keeps data written by different threads apart.
+namespace hw_utils {
+
+// Padding (and alignment) for data written by different threads. 128 on x86, where the L2
+// adjacent-line prefetcher fetches 64-byte lines in 128-byte pairs (so neighbouring lines still
+// ping-pong between cores), and on Apple Silicon, whose lines are 128 bytes. 64 elsewhere.
+// Override with -DHW_UTILS_FALSE_SHARING_PADDING=<bytes>.
+//
+// A fixed constant rather than std::hardware_destructive_interference_size, which GCC warns may
+// change between compiler versions and flags (-Winterference-size): this is used in layouts
+// shared across processes and persisted to files, so it must not.
+#if defined(HW_UTILS_FALSE_SHARING_PADDING)
+constexpr std::size_t sFalseSharingPadding = HW_UTILS_FALSE_SHARING_PADDING;
+#elif defined(__x86_64__) || defined(__i386__) || (defined(__aarch64__) && defined(__APPLE__))
+constexpr std::size_t sFalseSharingPadding = 128;
+#else
+constexpr std::size_t sFalseSharingPadding = 64;
+#endif
+
+static_assert(std::has_single_bit(sFalseSharingPadding), "Padding must be a power of two!");
+
+struct CpuLocation {
+    int cpu;
+    int core;     // Core id within its package: SMT siblings share it
+    int package;  // Socket
+    int node;     // NUMA node
+};
+
+// Sizes are per cache instance (e.g. one core's L2), in bytes. 0: unknown.
+struct Topology {
+    std::size_t cache_line_size = 0;
+    std::size_t l1d_size        = 0;
+    std::size_t l2_size         = 0;
+    std::size_t llc_size        = 0;
+
+    int num_cpus     = 1;  // Online logical CPUs
+    int num_cores    = 1;  // Physical cores
+    int num_packages = 1;
+    int num_nodes    = 1;  // NUMA nodes
+    int smt_per_core = 1;  // Hardware threads per core
+
+    std::vector<CpuLocation> cpus;  // Online CPUs (Linux only)
+};
+
+namespace detail {
+
+inline std::string Read_Line(const std::filesystem::path& aPath) {
+    std::ifstream cFile(aPath);
+    std::string   cLine;
+    std::getline(cFile, cLine);
+    return cLine;
+}
+
+inline int Read_Int(const std::filesystem::path& aPath, int aDefault) {
+    try {
+        return std::stoi(Read_Line(aPath));
+    } catch (const std::exception&) {
+        return aDefault;
+    }
+}
+
+// "32K", "1024K", "8M" (sysfs cache sizes)
+inline std::size_t Parse_Size(const std::string& aText) {
+    try {
+        std::size_t cEnd  = 0;
+        auto        cSize = static_cast<std::size_t>(std::stoull(aText, &cEnd));
+        if (cEnd < aText.size() && (aText[cEnd] == 'K'))
+            return cSize << 10;
+        if (cEnd < aText.size() && (aText[cEnd] == 'M'))
+            return cSize << 20;
+        return cSize;
+    } catch (const std::exception&) {
+        return 0;
+    }
+}
+
+// "0-3,8,10-11" (sysfs CPU lists)
+inline std::vector<int> Parse_Cpu_List(const std::string& aText) {
+    std::vector<int> cCpus;
+    std::size_t      cStart = 0;
+    while (cStart < aText.size()) {
+        auto cEnd   = std::min(aText.find(',', cStart), aText.size());
+        auto cRange = aText.substr(cStart, cEnd - cStart);
+        auto cDash  = cRange.find('-');
+        try {
+            auto cFirst = std::stoi(cRange.substr(0, cDash));
+            auto cLast  = cFirst;
+            if (cDash != std::string::npos)
+                cLast = std::stoi(cRange.substr(cDash + 1));
+            for (int cCpu = cFirst; cCpu <= cLast; ++cCpu)
+                cCpus.push_back(cCpu);
+        } catch (const std::exception&) {
+        }
+        cStart = cEnd + 1;
+    }
+    return cCpus;
+}
+
+#if defined(__linux__)
+inline void Read_Linux_Caches(Topology& aTopology) {
+    namespace fs = std::filesystem;
+
+    std::error_code cError;
+    fs::path        cCacheDir = "/sys/devices/system/cpu/cpu0/cache";
+    for (auto& cEntry : fs::directory_iterator(cCacheDir, cError)) {
+        if (!cEntry.path().filename().string().starts_with("index"))
+            continue;
+        auto cLevel = Read_Int(cEntry.path() / "level", 0);
+        auto cType  = Read_Line(cEntry.path() / "type");
+        auto cSize  = Parse_Size(Read_Line(cEntry.path() / "size"));
+        if (cType == "Instruction")
+            continue;
+
+        if (cLevel == 1) {
+            aTopology.l1d_size        = cSize;
+            aTopology.cache_line_size = Read_Int(cEntry.path() / "coherency_line_size", 0);
+        } else if (cLevel == 2)
+            aTopology.l2_size = cSize;
+        if ((cLevel >= 2) && (cSize > 0))
+            aTopology.llc_size = std::max(aTopology.llc_size, cSize);
+    }
+}
+
+inline void Read_Linux_Cpus(Topology& aTopology) {
+    namespace fs = std::filesystem;
+
+    fs::path cCpuDir = "/sys/devices/system/cpu";
+    auto     cOnline = Parse_Cpu_List(Read_Line(cCpuDir / "online"));
+
+    // CPU -> NUMA node, from each node's CPU list
+    std::vector<std::pair<int, int>> cNodeOfCpu;
+    std::error_code                  cError;
+    int                              cNumNodes = 0;
+    for (auto& cEntry : fs::directory_iterator("/sys/devices/system/node", cError)) {
+        auto cName = cEntry.path().filename().string();
+        if (!cName.starts_with("node") || (cName.size() == 4) ||
+            !std::isdigit(static_cast<unsigned char>(cName[4])))
+            continue;
+        auto cNode = std::stoi(cName.substr(4));
+        for (auto cCpu : Parse_Cpu_List(Read_Line(cEntry.path() / "cpulist")))
+            cNodeOfCpu.emplace_back(cCpu, cNode);
+        ++cNumNodes;
+    }
+
+    std::set<std::pair<int, int>> cCores;
+    std::set<int>                 cPackages;
+    for (auto cCpu : cOnline) {
+        auto cTopologyDir = cCpuDir / ("cpu" + std::to_string(cCpu)) / "topology";
+
+        CpuLocation cLocation;
+        cLocation.cpu     = cCpu;
+        cLocation.core    = Read_Int(cTopologyDir / "core_id", cCpu);
+        cLocation.package = Read_Int(cTopologyDir / "physical_package_id", 0);
+        cLocation.node    = 0;
+        for (auto [cNodeCpu, cNode] : cNodeOfCpu) {
+            if (cNodeCpu == cCpu)
+                cLocation.node = cNode;
+        }
+        aTopology.cpus.push_back(cLocation);
+        cCores.emplace(cLocation.package, cLocation.core);
+        cPackages.insert(cLocation.package);
+    }
+
+    if (!aTopology.cpus.empty()) {
+        aTopology.num_cpus     = static_cast<int>(aTopology.cpus.size());
+        aTopology.num_cores    = static_cast<int>(cCores.size());
+        aTopology.num_packages = static_cast<int>(cPackages.size());
+    }
+    aTopology.num_nodes = std::max(1, cNumNodes);
+}
+#endif
+
+#if defined(__APPLE__)
+template <typename ValueType>
+ValueType Read_Sysctl(const char* aName, ValueType aDefault) {
+    ValueType cValue = 0;
+    auto      cSize  = sizeof(cValue);
+    if ((sysctlbyname(aName, &cValue, &cSize, nullptr, 0) != 0) || (cValue == 0))
+        return aDefault;
+    return cValue;
+}
+
+inline void Read_Apple_Topology(Topology& aTopology) {
+    aTopology.cache_line_size = Read_Sysctl<std::int64_t>("hw.cachelinesize", 0);
+    aTopology.l1d_size        = Read_Sysctl<std::int64_t>("hw.l1dcachesize", 0);
+    aTopology.l2_size         = Read_Sysctl<std::int64_t>("hw.l2cachesize", 0);
+    aTopology.llc_size        = Read_Sysctl<std::int64_t>("hw.l3cachesize", aTopology.l2_size);
+    aTopology.num_cpus        = Read_Sysctl<std::int32_t>("hw.logicalcpu", 1);
+    aTopology.num_cores       = Read_Sysctl<std::int32_t>("hw.physicalcpu", 1);
+    aTopology.num_packages    = Read_Sysctl<std::int32_t>("hw.packages", 1);
+}
+#endif
+
+// glibc reports the caches through sysconf (often 0 on ARM)
+inline void Read_Sysconf_Caches(Topology& aTopology) {
+    auto cSysconf = [](int aName) {
+        auto cValue = sysconf(aName);
+        return (cValue > 0) ? static_cast<std::size_t>(cValue) : std::size_t{0};
+    };
+#if defined(_SC_LEVEL1_DCACHE_LINESIZE)
+    if (aTopology.cache_line_size == 0)
+        aTopology.cache_line_size = cSysconf(_SC_LEVEL1_DCACHE_LINESIZE);
+    if (aTopology.l1d_size == 0)
+        aTopology.l1d_size = cSysconf(_SC_LEVEL1_DCACHE_SIZE);
+    if (aTopology.l2_size == 0)
+        aTopology.l2_size = cSysconf(_SC_LEVEL2_CACHE_SIZE);
+    if (aTopology.llc_size == 0)
+        aTopology.llc_size = std::max(cSysconf(_SC_LEVEL3_CACHE_SIZE), aTopology.l2_size);
+#endif
+    if (aTopology.cpus.empty())
+        aTopology.num_cpus = std::max(1, static_cast<int>(cSysconf(_SC_NPROCESSORS_ONLN)));
+}
+
+inline Topology Read_Topology() {
+    Topology cTopology;
+#if defined(__linux__)
+    Read_Linux_Caches(cTopology);
+    Read_Linux_Cpus(cTopology);
+#elif defined(__APPLE__)
+    Read_Apple_Topology(cTopology);
+#endif
+    Read_Sysconf_Caches(cTopology);
+
+    cTopology.num_cores    = std::clamp(cTopology.num_cores, 1, cTopology.num_cpus);
+    cTopology.smt_per_core = std::max(1, cTopology.num_cpus / cTopology.num_cores);
+    return cTopology;
+}
+
+}  // namespace detail
+
+// Read on first use
+inline const Topology& System_Topology() {
+    static const Topology sTopology = detail::Read_Topology();
+    return sTopology;
+}
+
+// Whether sFalseSharingPadding covers this machine's cache lines (else padded data can still
+// share a line: rebuild with -DHW_UTILS_FALSE_SHARING_PADDING)
+inline bool Padding_Covers_Cache_Line() {
+    return System_Topology().cache_line_size <= sFalseSharingPadding;
+}
+
+// How many items of aItemBytes fit in aFraction of the L2 cache (256KiB if unknown), rounded
+// down to a power of two, and at least 2
+inline int L2_Resident_Count(std::size_t aItemBytes, double aFraction = 0.5) {
+    static constexpr std::size_t sDefaultL2Size = 256 * 1024;
+
+    auto cL2Size   = System_Topology().l2_size ? System_Topology().l2_size : sDefaultL2Size;
+    auto cBudget   = static_cast<std::size_t>(static_cast<double>(cL2Size) * aFraction);
+    auto cNumItems = cBudget / std::max<std::size_t>(aItemBytes, 1);
+    cNumItems      = std::bit_floor(std::clamp<std::size_t>(cNumItems, 2, std::size_t{1} << 30));
+    return static_cast<int>(cNumItems);
+}
+
+}  // namespace hw_utils
@@ -0,0 +1,87 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "PageAllocators.hpp"
+#include "PerfCounters.hpp"
+#include "SPSC.hpp"
+#include "test_allocator.hpp"
+
+// Compares the TLB behaviour of multi-MB rings backed by the different allocators.
+// Each iteration fills the whole ring in batches and drains it again, so every page is touched.
+//
+// Run with:
+//   ./allocator_bench --benchmark_counters_tabular=true
+
+// 64-byte entries: one cache line each
+struct alignas(64) Message {
+    std::uint64_t sequence;
+    std::uint64_t payload[7];
+};
+
+template <typename AllocatorType>
+AllocatorType Make_Allocator();
+
+template <>
+TestAllocator Make_Allocator<TestAllocator>() {
+    return TestAllocator();
+}
+
+template <>
+HugePageAllocator Make_Allocator<HugePageAllocator>() {
+    return HugePageAllocator(HugePages::Transparent);
+}
+
+template <>
+NumaAllocator Make_Allocator<NumaAllocator>() {
+    return NumaAllocator(0, true, true);  // Node 0, prefaulted, huge pages
+}
+
+template <typename AllocatorType>
+static void BM_RingSweep(benchmark::State& state) {
+    const auto cRingBytes = static_cast<int>(state.range(0)) * 1024 * 1024;
+    const auto cCapacity  = cRingBytes / static_cast<int>(sizeof(Message));
+
+    auto                               allocator = Make_Allocator<AllocatorType>();
+    SPSC<Message, WaitPolicy::NoWaits> queue;
+    queue.Allocate(allocator, cCapacity);
+
+    std::vector<Message> input(1024);
+    std::vector<Message> output;
+    output.reserve(input.size());
+
+    // Data TLB load misses, when the PMU is available (not in most VMs)
+    hw_utils::PerfCounters cTlbMisses({hw_utils::PerfEvent::DtlbMisses});
+    std::uint64_t          cNumMisses = 0;
+    for (auto _ : state) {
+        cTlbMisses.Start();
+
+        for (int cPushed = 0; cPushed < cCapacity; cPushed += static_cast<int>(input.size()))
+            queue.Emplace_Multiple(std::span<Message>(input));
+        while (!queue.empty()) {
+            output.clear();
+            queue.Pop_Multiple(output);
+            benchmark::DoNotOptimize(output.data());
+        }
+
+        cNumMisses += cTlbMisses.Stop().Get(hw_utils::PerfEvent::DtlbMisses).value_or(0);
+    }
+
+    state.SetItemsProcessed(state.iterations() * cCapacity);
+    state.SetBytesProcessed(state.iterations() * static_cast<std::int64_t>(cRingBytes));
+    if (cTlbMisses.Is_Available(hw_utils::PerfEvent::DtlbMisses)) {
+        state.counters["dTLB_misses/MiB"] = benchmark::Counter(
+            static_cast<double>(cNumMisses) / (state.iterations() * state.range(0)));
+    } else {
+        state.SetLabel("dTLB counters unavailable");
+    }
+
+    queue.Free(allocator);
+}
+
+BENCHMARK_TEMPLATE(BM_RingSweep, TestAllocator)->Arg(4)->Arg(64)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_RingSweep, HugePageAllocator)->Arg(4)->Arg(64)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_RingSweep, NumaAllocator)->Arg(4)->Arg(64)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
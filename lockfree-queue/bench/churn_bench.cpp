@@ -0,0 +1,44 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "PoolAllocators.hpp"
+#include "SPSC.hpp"
+#include "test_allocator.hpp"
+
+// Create/destroy churn: each iteration allocates N queues of assorted small capacities, pushes
+// one item through each, then frees them all in creation order. TestAllocator's Free() searches
+// the list of live pointers, so its cost grows with N; the slab and arena allocators free in
+// constant time and reuse their memory from one iteration to the next.
+
+using ChurnQueue = SPSC<std::uint64_t, WaitPolicy::NoWaits>;
+
+template <typename AllocatorType>
+static void BM_QueueChurn(benchmark::State& state) {
+    const auto cNumQueues = static_cast<int>(state.range(0));
+
+    AllocatorType           allocator;
+    std::vector<ChurnQueue> queues(cNumQueues);
+    for (auto _ : state) {
+        for (int cIndex = 0; cIndex < cNumQueues; ++cIndex) {
+            queues[cIndex].Allocate(allocator, 64 + 16 * (cIndex % 32));
+            queues[cIndex].Emplace(cIndex);
+        }
+
+        std::uint64_t cValue = 0;
+        for (auto& cQueue : queues) {
+            cQueue.Pop(cValue);
+            cQueue.Free(allocator);
+        }
+        benchmark::DoNotOptimize(cValue);
+    }
+
+    state.SetItemsProcessed(state.iterations() * cNumQueues);  // Queues created and destroyed
+}
+
+BENCHMARK_TEMPLATE(BM_QueueChurn, TestAllocator)->RangeMultiplier(10)->Range(10, 10000);
+BENCHMARK_TEMPLATE(BM_QueueChurn, SlabAllocator)->RangeMultiplier(10)->Range(10, 10000);
+BENCHMARK_TEMPLATE(BM_QueueChurn, ArenaAllocator)->RangeMultiplier(10)->Range(10, 10000);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,287 @@
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "Affinity.hpp"
+#include "PerfCounters.hpp"
+#include "SPSC.hpp"
+#include "test_allocator.hpp"
+
+// Two-thread throughput: the benchmark thread produces, a second thread consumes. Items are
+// pushed and popped one at a time (batch size 1) or with Emplace_Multiple/Pop_Multiple, and the
+// rate is what the producer sustains against a consumer that keeps up (a full queue stalls it).
+// Non-await sides spin (retrying on full/empty), await sides use the queue's waits. Spinning
+// needs a core per thread: on a single CPU the two sides just take turns.
+//
+// Where the PMU is available, both threads' hardware counters are reported per item (cycles,
+// instructions, branch and cache misses, HITM loads), to tell apart what a regression costs.
+//
+// --placement=none|compact|cores|spread pins the producer and consumer as threads 0 and 1 of that
+// placement (Linux only, see hw_utils::Placement): compact puts them on SMT siblings, cores on
+// two cores of a socket, spread on two sockets. Default none: the scheduler decides.
+//
+// Arguments: capacity/batch size. Write JSON for tracking with:
+//   ./spsc_bench --benchmark_out=spsc_bench.json --benchmark_out_format=json
+// (or "make run_benchmarks").
+
+template <int NumBytes>
+struct Payload {
+    static_assert(NumBytes % sizeof(std::uint64_t) == 0);
+    std::array<std::uint64_t, NumBytes / sizeof(std::uint64_t)> words = {};
+};
+
+constexpr int sItemsPerIteration = 1 << 14;
+
+hw_utils::Placement sPlacement = hw_utils::Placement::None;  // --placement
+
+void Label_Single_Cpu(benchmark::State& aState) {
+    if (std::thread::hardware_concurrency() < 2)
+        aState.SetLabel("single CPU: not representative");
+}
+
+// Adds each available event of the sample as a per-item counter
+void Report_Perf_Counters(benchmark::State& aState, const hw_utils::PerfSample& aSample,
+                          std::int64_t aNumItems) {
+    for (std::size_t cEvent = 0; cEvent < hw_utils::sNumPerfEvents; ++cEvent) {
+        auto cPerfEvent = static_cast<hw_utils::PerfEvent>(cEvent);
+        if (auto cValue = aSample.Get(cPerfEvent)) {
+            auto cName             = std::string(hw_utils::Perf_Event_Name(cPerfEvent)) + "/item";
+            aState.counters[cName] = static_cast<double>(*cValue) / static_cast<double>(aNumItems);
+        }
+    }
+}
+
+template <WaitPolicy Waiting, typename ItemType>
+void Consume(SPSC<ItemType, Waiting>& aQueue, int aBatchSize, const std::atomic<bool>& aStop) {
+    constexpr bool cPopAwait = Await_Pops(Waiting);
+
+    std::vector<ItemType> cOutput;
+    cOutput.reserve(aBatchSize);
+    ItemType cItem;
+    while (true) {
+        bool cPopped;
+        if (aBatchSize == 1) {
+            if constexpr (cPopAwait)
+                cPopped = aQueue.Pop_Await(cItem);
+            else
+                cPopped = aQueue.Pop(cItem);
+        } else {
+            cOutput.clear();
+            if constexpr (cPopAwait)
+                aQueue.Pop_Multiple_Await(cOutput);
+            else
+                aQueue.Pop_Multiple(cOutput);
+            cPopped = !cOutput.empty();
+        }
+
+        // Only stop once drained, so the queue can be freed
+        if (!cPopped && aStop.load(std::memory_order::acquire) && aQueue.empty())
+            return;
+        benchmark::DoNotOptimize(cItem);
+        benchmark::DoNotOptimize(cOutput.data());
+    }
+}
+
+template <WaitPolicy Waiting, typename ItemType>
+void Produce(SPSC<ItemType, Waiting>& aQueue, std::span<ItemType> aBatch) {
+    constexpr bool cPushAwait = Await_Pushes(Waiting);
+
+    if (aBatch.size() == 1) {
+        if constexpr (cPushAwait)
+            aQueue.Emplace_Await(aBatch[0]);
+        else {
+            while (!aQueue.Emplace(aBatch[0]))
+                ;
+        }
+        return;
+    }
+
+    if constexpr (cPushAwait)
+        aQueue.Emplace_Multiple_Await(aBatch);
+    else {
+        while (!aBatch.empty())
+            aBatch = aQueue.Emplace_Multiple(aBatch);
+    }
+}
+
+template <WaitPolicy Waiting, int NumBytes>
+static void BM_SPSC_Throughput(benchmark::State& state) {
+    using ItemType = Payload<NumBytes>;
+
+    const auto cCapacity  = static_cast<int>(state.range(0));
+    const auto cBatchSize = static_cast<int>(state.range(1));
+
+    TestAllocator           allocator;
+    SPSC<ItemType, Waiting> queue;
+    queue.Allocate(allocator, cCapacity);
+
+    // The producer is the benchmark thread: restored afterwards, as it runs every benchmark
+    auto                     cCpus = hw_utils::Placement_Cpus(sPlacement, 2);
+    hw_utils::ScopedAffinity producerCpus;
+    hw_utils::Pin_This_Thread(cCpus, 0);
+
+    // Before the consumer starts, so its counts are included (once it exits)
+    hw_utils::PerfCounters counters;
+    counters.Start();
+
+    std::atomic<bool> stop{false};
+    std::thread       consumer([&]() {
+        hw_utils::Pin_This_Thread(cCpus, 1);
+        Consume<Waiting, ItemType>(queue, cBatchSize, stop);
+    });
+
+    std::vector<ItemType> batch(cBatchSize);
+    for (auto _ : state) {
+        for (int cPushed = 0; cPushed < sItemsPerIteration; cPushed += cBatchSize)
+            Produce(queue, std::span<ItemType>(batch));
+    }
+
+    stop.store(true, std::memory_order::release);
+    if constexpr (Await_Pops(Waiting))
+        queue.End_PopWaiting();
+    consumer.join();
+    auto cSample = counters.Stop();
+    queue.Free(allocator);
+
+    state.SetItemsProcessed(state.iterations() * sItemsPerIteration);
+    state.SetBytesProcessed(state.iterations() * sItemsPerIteration * NumBytes);
+    Report_Perf_Counters(state, cSample, state.iterations() * sItemsPerIteration);
+    Label_Single_Cpu(state);
+}
+
+// Baseline: a std::deque bounded to the same capacity, guarded by a std::mutex
+template <typename ItemType>
+class MutexQueue {
+  public:
+    explicit MutexQueue(int aCapacity) : mCapacity(aCapacity) {}
+
+    // Pushes as much of the batch as fits, returning the rest
+    std::span<ItemType> Emplace_Multiple(std::span<ItemType> aBatch) {
+        std::lock_guard cLock(mMutex);
+        auto            cNumToPush = std::min(aBatch.size(), mCapacity - mItems.size());
+        mItems.insert(mItems.end(), aBatch.begin(), aBatch.begin() + cNumToPush);
+        return aBatch.subspan(cNumToPush);
+    }
+
+    void Pop_Multiple(std::vector<ItemType>& aPopped) {
+        std::lock_guard cLock(mMutex);
+        auto            cNumToPop = std::min(aPopped.capacity() - aPopped.size(), mItems.size());
+        aPopped.insert(aPopped.end(), mItems.begin(), mItems.begin() + cNumToPop);
+        mItems.erase(mItems.begin(), mItems.begin() + cNumToPop);
+    }
+
+    bool empty() {
+        std::lock_guard cLock(mMutex);
+        return mItems.empty();
+    }
+
+  private:
+    std::mutex           mMutex;
+    std::deque<ItemType> mItems;
+    std::size_t          mCapacity;
+};
+
+template <int NumBytes>
+static void BM_MutexDeque_Throughput(benchmark::State& state) {
+    using ItemType = Payload<NumBytes>;
+
+    const auto cCapacity  = static_cast<int>(state.range(0));
+    const auto cBatchSize = static_cast<int>(state.range(1));
+
+    auto                     cCpus = hw_utils::Placement_Cpus(sPlacement, 2);
+    hw_utils::ScopedAffinity producerCpus;
+    hw_utils::Pin_This_Thread(cCpus, 0);
+
+    MutexQueue<ItemType>   queue(cCapacity);
+    std::atomic<bool>      stop{false};
+    hw_utils::PerfCounters counters;
+    counters.Start();
+
+    std::thread consumer([&]() {
+        hw_utils::Pin_This_Thread(cCpus, 1);
+        std::vector<ItemType> cOutput;
+        cOutput.reserve(cBatchSize);
+        while (!stop.load(std::memory_order::acquire) || !queue.empty()) {
+            cOutput.clear();
+            queue.Pop_Multiple(cOutput);
+            benchmark::DoNotOptimize(cOutput.data());
+        }
+    });
+
+    std::vector<ItemType> batch(cBatchSize);
+    for (auto _ : state) {
+        for (int cPushed = 0; cPushed < sItemsPerIteration; cPushed += cBatchSize) {
+            auto cToPush = std::span<ItemType>(batch);
+            while (!cToPush.empty())
+                cToPush = queue.Emplace_Multiple(cToPush);
+        }
+    }
+
+    stop.store(true, std::memory_order::release);
+    consumer.join();
+    auto cSample = counters.Stop();
+
+    state.SetItemsProcessed(state.iterations() * sItemsPerIteration);
+    state.SetBytesProcessed(state.iterations() * sItemsPerIteration * NumBytes);
+    Report_Perf_Counters(state, cSample, state.iterations() * sItemsPerIteration);
+    Label_Single_Cpu(state);
+}
+
+// Capacity x batch size sweep
+static void Sweep(benchmark::internal::Benchmark* aBenchmark) {
+    aBenchmark->ArgNames({"capacity", "batch"});
+    aBenchmark->ArgsProduct({{64, 1024, 65536}, {1, 16, 256}});
+    aBenchmark->UseRealTime();
+}
+
+// Await policies at one capacity (compare with NoWaits/64 from the sweep)
+static void Policies(benchmark::internal::Benchmark* aBenchmark) {
+    aBenchmark->ArgNames({"capacity", "batch"});
+    aBenchmark->ArgsProduct({{1024}, {1, 16}});
+    aBenchmark->UseRealTime();
+}
+
+BENCHMARK_TEMPLATE(BM_SPSC_Throughput, WaitPolicy::NoWaits, 8)->Apply(Sweep);
+BENCHMARK_TEMPLATE(BM_SPSC_Throughput, WaitPolicy::NoWaits, 64)->Apply(Sweep);
+BENCHMARK_TEMPLATE(BM_SPSC_Throughput, WaitPolicy::NoWaits, 256)->Apply(Sweep);
+
+BENCHMARK_TEMPLATE(BM_SPSC_Throughput, WaitPolicy::PushAwait, 64)->Apply(Policies);
+BENCHMARK_TEMPLATE(BM_SPSC_Throughput, WaitPolicy::PopAwait, 64)->Apply(Policies);
+BENCHMARK_TEMPLATE(BM_SPSC_Throughput, WaitPolicy::BothAwait, 64)->Apply(Policies);
+
+BENCHMARK_TEMPLATE(BM_MutexDeque_Throughput, 8)->Apply(Sweep);
+BENCHMARK_TEMPLATE(BM_MutexDeque_Throughput, 64)->Apply(Sweep);
+
+int main(int argc, char** argv) {
+    benchmark::Initialize(&argc, argv);
+
+    // Ours, after the benchmark library's own flags are removed
+    for (int arg = 1; arg < argc; ++arg) {
+        std::string_view text = argv[arg];
+        if (!text.starts_with("--placement=")) {
+            std::fprintf(stderr, "%s: unrecognized argument '%s'\n", argv[0], argv[arg]);
+            return 1;
+        }
+        auto placement = hw_utils::Parse_Placement(text.substr(text.find('=') + 1));
+        if (!placement) {
+            std::fprintf(stderr, "Usage: %s [--placement=none|compact|cores|spread]\n", argv[0]);
+            return 1;
+        }
+        sPlacement = *placement;
+    }
+    benchmark::AddCustomContext("placement", hw_utils::Placement_Name(sPlacement));
+
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
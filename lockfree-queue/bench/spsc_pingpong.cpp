@@ -0,0 +1,165 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Affinity.hpp"
+#include "LatencyHistogram.hpp"
+#include "SPSC.hpp"
+#include "test_allocator.hpp"
+
+// Round-trip latency between two pinned threads: the benchmark thread pushes a token into one
+// queue, an echo thread pops it and pushes it back through a second queue. One iteration is one
+// round trip, timed individually (TSC), and reported as min/median/p99/p99.9 in nanoseconds.
+// Half the round trip is the one-way handoff latency between the two cores.
+//
+// Core pairs are picked from the topology of the CPUs this process may run on (hw_utils::
+// Allowed_Cpus()): SMT siblings (same physical core), two cores of the same socket, and two
+// sockets, where present.
+
+template <WaitPolicy Waiting>
+using TokenQueue = SPSC<std::uint64_t, Waiting>;
+
+template <WaitPolicy Waiting>
+void Push_Token(TokenQueue<Waiting>& aQueue, std::uint64_t aToken) {
+    if constexpr (Await_Pushes(Waiting))
+        aQueue.Emplace_Await(aToken);
+    else {
+        while (!aQueue.Emplace(aToken))
+            ;
+    }
+}
+
+template <WaitPolicy Waiting>
+std::uint64_t Pop_Token(TokenQueue<Waiting>& aQueue) {
+    std::uint64_t cToken = 0;
+    if constexpr (Await_Pops(Waiting))
+        aQueue.Pop_Await(cToken);
+    else {
+        while (!aQueue.Pop(cToken))
+            ;
+    }
+    return cToken;
+}
+
+constexpr std::uint64_t sStopToken = ~std::uint64_t{0};
+
+template <WaitPolicy Waiting>
+void BM_PingPong(benchmark::State& state, int aPingCpu, int aPongCpu) {
+    TestAllocator       allocator;
+    TokenQueue<Waiting> ping;
+    TokenQueue<Waiting> pong;
+    ping.Allocate(allocator, 2);
+    pong.Allocate(allocator, 2);
+
+    // Restored afterwards: the benchmark thread runs every benchmark
+    hw_utils::ScopedAffinity originalCpus;
+    if ((aPingCpu >= 0) && !hw_utils::Pin_This_Thread(aPingCpu)) {
+        state.SkipWithError("Can't pin to the first CPU");
+        return;
+    }
+
+    std::atomic<bool> pinned{true};
+
+    std::thread echo([&]() {
+        if ((aPongCpu >= 0) && !hw_utils::Pin_This_Thread(aPongCpu))
+            pinned = false;
+        while (true) {
+            auto cToken = Pop_Token(ping);
+            Push_Token(pong, cToken);
+            if (cToken == sStopToken)
+                return;
+        }
+    });
+
+    std::vector<std::uint64_t> roundTrips;
+    roundTrips.reserve(1 << 20);
+    std::uint64_t token = 0;
+    for (auto _ : state) {
+        auto cStart = TimestampClock::Now();
+        Push_Token(ping, token);
+        token = Pop_Token(pong) + 1;
+        roundTrips.push_back(TimestampClock::Now() - cStart);
+    }
+
+    Push_Token(ping, sStopToken);
+    Pop_Token(pong);
+    echo.join();
+    ping.Free(allocator);
+    pong.Free(allocator);
+
+    if (!pinned) {
+        state.SkipWithError("Can't pin to the second CPU");
+        return;
+    }
+
+    // Exact order statistics, in nanoseconds
+    std::sort(roundTrips.begin(), roundTrips.end());
+    auto cNanosecondsPerTick = TimestampClock::Nanoseconds_Per_Tick();
+
+    auto cPercentile = [&](double aFraction) {
+        auto cIndex = static_cast<std::size_t>(aFraction * (roundTrips.size() - 1));
+        return roundTrips[cIndex] * cNanosecondsPerTick;
+    };
+    state.counters["min_ns"]   = cPercentile(0.0);
+    state.counters["p50_ns"]   = cPercentile(0.5);
+    state.counters["p99_ns"]   = cPercentile(0.99);
+    state.counters["p99.9_ns"] = cPercentile(0.999);
+    state.SetItemsProcessed(state.iterations());  // Round trips
+}
+
+struct CpuPair {
+    const char* relation;
+    int         ping;  // -1: unpinned
+    int         pong;
+};
+
+// The first allowed CPU, paired with the first CPU in each relation to it
+std::vector<CpuPair> Find_Pairs() {
+    static constexpr hw_utils::CpuRelation sRelations[] = {hw_utils::CpuRelation::SmtSiblings,
+                                                           hw_utils::CpuRelation::SameSocket,
+                                                           hw_utils::CpuRelation::CrossSocket};
+
+    auto                 cCpus = hw_utils::Allowed_Cpus();
+    std::vector<CpuPair> cPairs;
+    for (auto cRelation : sRelations) {
+        for (auto& cCpu : cCpus) {
+            if (hw_utils::Relation(cCpus.front(), cCpu) == cRelation) {
+                cPairs.push_back({hw_utils::Relation_Name(cRelation), cCpus.front().cpu, cCpu.cpu});
+                break;
+            }
+        }
+    }
+    if (cPairs.empty())
+        cPairs.push_back({"unpinned", -1, -1});  // A single CPU
+    return cPairs;
+}
+
+template <WaitPolicy Waiting>
+void Register_Pair(const char* aPolicyName, const CpuPair& aPair) {
+    auto cName = std::string("BM_PingPong<") + aPolicyName + ">/" + aPair.relation;
+    if (aPair.ping >= 0)
+        cName += "/cpus:" + std::to_string(aPair.ping) + "," + std::to_string(aPair.pong);
+    benchmark::RegisterBenchmark(cName.c_str(), BM_PingPong<Waiting>, aPair.ping, aPair.pong)
+        ->UseRealTime();
+}
+
+int main(int argc, char** argv) {
+    for (auto& cPair : Find_Pairs()) {
+        Register_Pair<WaitPolicy::NoWaits>("NoWaits", cPair);
+        Register_Pair<WaitPolicy::PushAwait>("PushAwait", cPair);
+        Register_Pair<WaitPolicy::PopAwait>("PopAwait", cPair);
+        Register_Pair<WaitPolicy::BothAwait>("BothAwait", cPair);
+    }
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
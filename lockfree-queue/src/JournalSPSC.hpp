@@ -0,0 +1,425 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <new>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#include "common.hpp"
+
+// Crash-recoverable SPSC journal backed by a memory-mapped file.
+// The file starts with a persisted header (geometry, push index, committed pop index, generation)
+// followed by the ring storage. Consumers Pop() through a process-local read cursor and Commit()
+// it once the entries have been handled: slots are only reused after being committed, so a
+// consumer that crashes re-opens the journal and replays everything after the last commit.
+//
+// Entries live in the page cache as soon as they are published, so they always survive a process
+// crash. The durability mode decides what survives a machine crash:
+//   Kernel:    Nothing is forced, the kernel writes pages back whenever it likes.
+//   Batched:   fdatasync() every aSyncInterval pushes/commits (and on Sync()/destruction).
+//   Immediate: Each push msync()s its slots before publishing the push index, then the header.
+enum class Durability { Kernel = 0, Batched, Immediate };
+
+struct JournalHeader {
+    static constexpr std::uint32_t sMagic   = 0x4A524E4C;  // "JRNL"
+    static constexpr std::uint32_t sVersion = 2;           // 2: 128-byte index padding on x86
+    static constexpr auto          sAlign   = hardware_destructive_interference_size;
+
+    JournalHeader(int aCapacity, int aIndexEnd, std::uint32_t aElementSize,
+                  std::uint32_t aElementAlign, std::uint64_t aStorageOffset)
+        : mVersion(sVersion), mElementSize(aElementSize), mElementAlign(aElementAlign),
+          mCapacity(aCapacity), mIndexEnd(aIndexEnd), mStorageOffset(aStorageOffset) {}
+
+    // Written last when creating the journal
+    std::atomic<std::uint32_t> mMagic{0};
+
+    // Geometry, immutable after creation
+    std::uint32_t mVersion;
+    std::uint32_t mElementSize;
+    std::uint32_t mElementAlign;
+    int           mCapacity;
+    int           mIndexEnd;       // at this, we need to wrap indices around to zero
+    std::uint64_t mStorageOffset;  // From the start of the file
+
+    // Number of times the journal has been opened
+    std::atomic<std::uint64_t> mGeneration{0};
+
+    // OVER-ALIGNED MEMBERS
+    PaddedAtomicInt mPushIndex;  // Published entries end here
+    PaddedAtomicInt mPopIndex;   // Committed by the consumer: entries before it are done
+};
+
+template <typename DataType>
+class JournalSPSC {
+    static_assert(std::is_trivially_copyable_v<DataType>,
+                  "Journaled queues can only hold trivially copyable types!");
+    static_assert(std::atomic<int>::is_always_lock_free &&
+                      std::atomic<std::uint64_t>::is_always_lock_free,
+                  "Persisted indices must be plain integers!");
+
+  public:
+    // Opens the journal at aPath, creating it with aCapacity entries if it doesn't exist.
+    // An existing journal keeps its own capacity and resumes from its last committed pop index.
+    static JournalSPSC Open(const std::string& aPath, int aCapacity,
+                            Durability aDurability = Durability::Kernel, int aSyncInterval = 64) {
+        Assert(aSyncInterval > 0, "Invalid sync interval {}!\n", aSyncInterval);
+
+        auto cFd = open(aPath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (cFd < 0)
+            throw std::system_error(errno, std::generic_category(), "open " + aPath);
+
+        JournalSPSC cJournal;
+        cJournal.mFd           = cFd;
+        cJournal.mDurability   = aDurability;
+        cJournal.mSyncInterval = aSyncInterval;
+
+        struct stat cStat;
+        if (fstat(cFd, &cStat) != 0)
+            throw std::system_error(errno, std::generic_category(), "fstat " + aPath);
+        if ((cStat.st_size == 0) || !cJournal.Recover(static_cast<std::size_t>(cStat.st_size)))
+            cJournal.Initialize(aCapacity);
+        return cJournal;
+    }
+
+    // Constructor/Destructor
+    JournalSPSC() = default;
+    ~JournalSPSC() { Release(); }
+
+    JournalSPSC(JournalSPSC&& aOther) noexcept { Take(aOther); }
+    JournalSPSC& operator=(JournalSPSC&& aOther) noexcept {
+        if (this != &aOther) {
+            Release();
+            Take(aOther);
+        }
+        return *this;
+    }
+
+    JournalSPSC(const JournalSPSC&)            = delete;
+    JournalSPSC& operator=(const JournalSPSC&) = delete;
+
+    bool Is_Open() const { return (mHeader != nullptr); }
+
+    std::uint64_t Generation() const {
+        return mHeader->mGeneration.load(std::memory_order::relaxed);
+    }
+
+    // Producer
+
+    template <typename... ArgumentTypes>
+    bool Emplace(ArgumentTypes&&... aArguments) {
+        // Load indices
+        // Push load relaxed: Only this thread can modify it
+        auto cUnwrappedPushIndex = mHeader->mPushIndex.value.load(std::memory_order::relaxed);
+        // Pop load acquire: Slot reuse cannot be reordered above the consumer's commit
+        auto cUnwrappedPopIndex = mHeader->mPopIndex.value.load(std::memory_order::acquire);
+
+        // Guard against the journal being full (of uncommitted entries)
+        auto cIndexDelta = cUnwrappedPushIndex - cUnwrappedPopIndex;
+        if ((cIndexDelta == mCapacity) || (cIndexDelta == (mCapacity - mIndexEnd)))
+            return false;  // Full. The second check handled wrap-around
+
+        // Emplace the object
+        auto cPushIndex = cUnwrappedPushIndex % mCapacity;
+        auto cAddress   = mStorage + cPushIndex * sizeof(DataType);
+        new (cAddress) DataType(std::forward<ArgumentTypes>(aArguments)...);
+
+        Publish_Push(cUnwrappedPushIndex, cPushIndex, 1);
+        return true;
+    }
+
+    std::span<const DataType> Emplace_Multiple(std::span<const DataType> aSpan) {
+        // Load indices (comments are identical to Emplace())
+        auto cUnwrappedPushIndex = mHeader->mPushIndex.value.load(std::memory_order::relaxed);
+        auto cUnwrappedPopIndex  = mHeader->mPopIndex.value.load(std::memory_order::acquire);
+
+        // Can only push up to the committed pop index
+        auto cMaxPushIndex      = cUnwrappedPopIndex + mCapacity;
+        auto cMaxSlotsAvailable = cMaxPushIndex - cUnwrappedPushIndex;
+        cMaxSlotsAvailable -= (cMaxSlotsAvailable >= mIndexEnd) ? mIndexEnd : 0;
+        const auto cSpanSize  = static_cast<int>(aSpan.size());
+        auto       cNumToPush = std::min(cSpanSize, cMaxSlotsAvailable);
+        if (cNumToPush == 0)
+            return aSpan;  // The journal is full.
+
+        // Push data, in up to two chunks if wrapping around
+        auto cPushIndex         = cUnwrappedPushIndex % mCapacity;
+        auto cDistanceBeyondEnd = (cPushIndex + cNumToPush) - mCapacity;
+        auto cInitialLength     = cNumToPush - std::max(cDistanceBeyondEnd, 0);
+        std::memcpy(mStorage + cPushIndex * sizeof(DataType), aSpan.data(),
+                    cInitialLength * sizeof(DataType));
+        if (cDistanceBeyondEnd > 0) {
+            std::memcpy(mStorage, aSpan.data() + cInitialLength,
+                        cDistanceBeyondEnd * sizeof(DataType));
+        }
+
+        Publish_Push(cUnwrappedPushIndex, cPushIndex, cNumToPush);
+
+        // Return unfinished entries
+        return aSpan.subspan(cNumToPush);
+    }
+
+    // Consumer
+
+    // Reads the next entry without committing it
+    bool Pop(DataType& aPopped) {
+        // Push load acquire: The read cannot be reordered above this
+        auto cUnwrappedPushIndex = mHeader->mPushIndex.value.load(std::memory_order::acquire);
+        if (mReadIndex == cUnwrappedPushIndex)
+            return false;  // Nothing left to read
+
+        auto cReadIndex = mReadIndex % mCapacity;
+        std::memcpy(&aPopped, mStorage + cReadIndex * sizeof(DataType), sizeof(DataType));
+        mReadIndex = Increase_Index(mReadIndex, 1);
+        ++mNumUncommitted;
+        return true;
+    }
+
+    // Reads as many entries as fit in aPopped's spare capacity, without committing them
+    template <typename ContainerType>
+    void Pop_Multiple(ContainerType& aPopped) {
+        // Push load acquire: The read cannot be reordered above this
+        auto cUnwrappedPushIndex = mHeader->mPushIndex.value.load(std::memory_order::acquire);
+
+        auto cMaxSlotsAvailable = cUnwrappedPushIndex - mReadIndex;
+        cMaxSlotsAvailable += (cMaxSlotsAvailable < 0) ? mIndexEnd : 0;
+        auto cOutputSpaceAvailable = static_cast<int>(aPopped.capacity() - aPopped.size());
+        auto cNumToPop             = std::min(cOutputSpaceAvailable, cMaxSlotsAvailable);
+        if (cNumToPop == 0)
+            return;  // Nothing left to read
+
+        auto cReadIndex         = mReadIndex % mCapacity;
+        auto cReadFromData      = std::launder(reinterpret_cast<DataType*>(mStorage)) + cReadIndex;
+        auto cDistanceBeyondEnd = (cReadIndex + cNumToPop) - mCapacity;
+        auto cInitialLength     = cNumToPop - std::max(cDistanceBeyondEnd, 0);
+        aPopped.insert(std::end(aPopped), cReadFromData, cReadFromData + cInitialLength);
+        if (cDistanceBeyondEnd > 0) {
+            cReadFromData = std::launder(reinterpret_cast<DataType*>(mStorage));
+            aPopped.insert(std::end(aPopped), cReadFromData, cReadFromData + cDistanceBeyondEnd);
+        }
+
+        mReadIndex = Increase_Index(mReadIndex, cNumToPop);
+        mNumUncommitted += cNumToPop;
+    }
+
+    // Marks everything read so far as handled: it won't be replayed, and its slots can be reused
+    void Commit() {
+        if (mNumUncommitted == 0)
+            return;
+
+        // Pop store release: The reads cannot be reordered below this
+        mHeader->mPopIndex.value.store(mReadIndex, std::memory_order::release);
+        if (mDurability == Durability::Immediate)
+            Sync_Range(mSegment, sizeof(JournalHeader));
+        Count_Operations(mNumUnsyncedCommits, mNumUncommitted);
+        mNumUncommitted = 0;
+    }
+
+    // Forces all published entries and commits to stable storage
+    void Sync() {
+        if (fdatasync(mFd) != 0)
+            throw std::system_error(errno, std::generic_category(), "fdatasync");
+    }
+
+    // Journal state
+    // Published entries that haven't been committed yet (read or not)
+    size_t size() const {
+        // Relaxed: Nothing to synchronize when reading these
+        auto cDelta = mHeader->mPushIndex.value.load(std::memory_order::relaxed) -
+                      mHeader->mPopIndex.value.load(std::memory_order::relaxed);
+        return static_cast<size_t>(cDelta + ((cDelta < 0) ? mIndexEnd : 0));
+    }
+
+    bool empty() const { return size() == 0; }
+
+    int capacity() const { return mCapacity; }
+
+  private:
+    // File management
+    static std::size_t Page_Size() { return static_cast<std::size_t>(sysconf(_SC_PAGESIZE)); }
+
+    // The header gets its own page(s), so syncing it never touches the storage
+    static std::size_t Storage_Offset() {
+        auto cPageSize = Page_Size();
+        return ((sizeof(JournalHeader) + cPageSize - 1) / cPageSize) * cPageSize;
+    }
+
+    void Initialize(int aCapacity) {
+        Assert(aCapacity > 0, "Invalid capacity {}!\n", aCapacity);
+
+        // Calculate where index values will wrap-around to zero
+        static constexpr auto sMaxValue          = std::numeric_limits<int>::max();
+        auto                  cMaxNumWrapArounds = sMaxValue / aCapacity;
+        Assert(cMaxNumWrapArounds >= 2, "Not enough wrap-arounds!\n");
+
+        // Size the file (new pages are zero-filled) and map it
+        mMappedBytes = Storage_Offset() + aCapacity * sizeof(DataType);
+        if (ftruncate(mFd, static_cast<off_t>(mMappedBytes)) != 0)
+            throw std::system_error(errno, std::generic_category(), "ftruncate");
+        Map();
+
+        // Placement-construct the header and make it durable before the journal is used
+        mHeader = new (mSegment) JournalHeader(aCapacity, aCapacity * cMaxNumWrapArounds,
+                                               sizeof(DataType), alignof(DataType),
+                                               Storage_Offset());
+        mHeader->mMagic.store(JournalHeader::sMagic, std::memory_order::release);
+        Cache_Geometry();
+        mHeader->mGeneration.store(1, std::memory_order::relaxed);
+        Sync();
+    }
+
+    // Returns false if the file was never fully initialized (a crash between sizing it and
+    // storing the magic leaves it zero-filled): it holds nothing, so it can be initialized again
+    bool Recover(std::size_t aFileSize) {
+        mMappedBytes = aFileSize;
+        if (mMappedBytes < Storage_Offset())
+            throw std::runtime_error("Journal file is too small!");
+        Map();
+
+        // Validate the header before trusting its geometry
+        mHeader     = std::launder(reinterpret_cast<JournalHeader*>(mSegment));
+        auto cMagic = mHeader->mMagic.load(std::memory_order::acquire);
+        if (cMagic == 0) {
+            munmap(mSegment, mMappedBytes);
+            mSegment = nullptr;
+            mHeader  = nullptr;
+            return false;
+        }
+        if (cMagic != JournalHeader::sMagic)
+            throw std::runtime_error("Not a journal file!");
+        if ((mHeader->mVersion != JournalHeader::sVersion) ||
+            (mHeader->mElementSize != sizeof(DataType)) ||
+            (mHeader->mElementAlign != alignof(DataType)))
+            throw std::runtime_error("Journal file holds a different data type!");
+        if (mHeader->mStorageOffset + mHeader->mCapacity * sizeof(DataType) > mMappedBytes)
+            throw std::runtime_error("Journal file is truncated!");
+        Cache_Geometry();
+
+        // Resume reading after the last commit: uncommitted entries are replayed
+        mHeader->mGeneration.fetch_add(1, std::memory_order::relaxed);
+        if (mDurability != Durability::Kernel)
+            Sync_Range(mSegment, sizeof(JournalHeader));
+        return true;
+    }
+
+    void Map() {
+        auto cAddress = mmap(nullptr, mMappedBytes, PROT_READ | PROT_WRITE, MAP_SHARED, mFd, 0);
+        if (cAddress == MAP_FAILED)
+            throw std::system_error(errno, std::generic_category(), "mmap");
+        mSegment = static_cast<std::byte*>(cAddress);
+    }
+
+    void Cache_Geometry() {
+        mStorage   = mSegment + mHeader->mStorageOffset;
+        mCapacity  = mHeader->mCapacity;
+        mIndexEnd  = mHeader->mIndexEnd;
+        mReadIndex = mHeader->mPopIndex.value.load(std::memory_order::acquire);
+    }
+
+    void Release() {
+        if (mSegment != nullptr) {
+            if (mDurability != Durability::Kernel)
+                fdatasync(mFd);  // Best effort: destructors can't throw
+            munmap(mSegment, mMappedBytes);
+        }
+        if (mFd >= 0)
+            close(mFd);
+        mHeader  = nullptr;
+        mSegment = nullptr;
+        mStorage = nullptr;
+        mFd      = -1;
+    }
+
+    void Take(JournalSPSC& aOther) {
+        mHeader         = std::exchange(aOther.mHeader, nullptr);
+        mSegment        = std::exchange(aOther.mSegment, nullptr);
+        mStorage        = std::exchange(aOther.mStorage, nullptr);
+        mMappedBytes    = std::exchange(aOther.mMappedBytes, 0);
+        mFd             = std::exchange(aOther.mFd, -1);
+        mCapacity       = aOther.mCapacity;
+        mIndexEnd       = aOther.mIndexEnd;
+        mReadIndex      = aOther.mReadIndex;
+        mNumUncommitted = aOther.mNumUncommitted;
+        mDurability     = aOther.mDurability;
+        mSyncInterval   = aOther.mSyncInterval;
+
+        mNumUnsyncedPushes  = aOther.mNumUnsyncedPushes;
+        mNumUnsyncedCommits = aOther.mNumUnsyncedCommits;
+    }
+
+    // Durability helpers
+    void Sync_Range(std::byte* aBegin, std::size_t aNumBytes) {
+        // msync() needs a page-aligned start address
+        auto cPageMask = ~(static_cast<std::uintptr_t>(Page_Size()) - 1);
+        auto cBegin    = reinterpret_cast<std::uintptr_t>(aBegin) & cPageMask;
+        auto cEnd      = reinterpret_cast<std::uintptr_t>(aBegin) + aNumBytes;
+        if (msync(reinterpret_cast<void*>(cBegin), cEnd - cBegin, MS_SYNC) != 0)
+            throw std::system_error(errno, std::generic_category(), "msync");
+    }
+
+    void Publish_Push(int aUnwrappedPushIndex, int aPushIndex, int aNumPushed) {
+        // Immediate: The entries must be durable before the index that publishes them
+        if (mDurability == Durability::Immediate) {
+            auto cNumBeforeEnd = std::min(aNumPushed, mCapacity - aPushIndex);
+            Sync_Range(mStorage + aPushIndex * sizeof(DataType), cNumBeforeEnd * sizeof(DataType));
+            if (cNumBeforeEnd < aNumPushed)
+                Sync_Range(mStorage, (aNumPushed - cNumBeforeEnd) * sizeof(DataType));
+        }
+
+        // Advance push index
+        auto cNewPushIndex = Increase_Index(aUnwrappedPushIndex, aNumPushed);
+        // Push store release: Object creation cannot be reordered below this
+        mHeader->mPushIndex.value.store(cNewPushIndex, std::memory_order::release);
+
+        if (mDurability == Durability::Immediate)
+            Sync_Range(mSegment, sizeof(JournalHeader));
+        Count_Operations(mNumUnsyncedPushes, aNumPushed);
+    }
+
+    // Each side counts its own operations, so producer and consumer threads don't share a counter
+    void Count_Operations(int& aNumUnsynced, int aNumOperations) {
+        if (mDurability != Durability::Batched)
+            return;
+
+        aNumUnsynced += aNumOperations;
+        if (aNumUnsynced >= mSyncInterval) {
+            Sync();
+            aNumUnsynced = 0;
+        }
+    }
+
+    int Increase_Index(int aIndex, int aIncrease) const {
+        int cNewIndex = aIndex + aIncrease;
+        cNewIndex -= (cNewIndex >= mIndexEnd) ? mIndexEnd : 0;
+        return cNewIndex;
+    }
+
+    // Persisted state lives in the file, everything else here is process-local
+    JournalHeader* mHeader         = nullptr;
+    std::byte*     mSegment        = nullptr;  // Start of this process' mapping
+    std::byte*     mStorage        = nullptr;  // mSegment + mHeader->mStorageOffset
+    std::size_t    mMappedBytes    = 0;
+    int            mFd             = -1;
+    int            mCapacity       = 0;
+    int            mIndexEnd       = 0;
+    int            mReadIndex      = 0;  // Consumer cursor, committed by Commit()
+    int            mNumUncommitted = 0;
+    Durability     mDurability     = Durability::Kernel;
+    int            mSyncInterval   = 64;
+
+    // Batched: operations since the last fdatasync(), per side
+    int mNumUnsyncedPushes  = 0;
+    int mNumUnsyncedCommits = 0;
+};
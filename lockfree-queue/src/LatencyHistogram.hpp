@@ -0,0 +1,143 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <cpuid.h>
+    #include <x86intrin.h>
+#endif
+
+#include "common.hpp"
+
+// Timestamps for latency tracing: the TSC where it is invariant (constant rate, doesn't stop in
+// idle states: every x86-64 CPU of the last decade), else std::chrono::steady_clock. Ticks are
+// only meaningful as differences; convert them with Nanoseconds_Per_Tick().
+class TimestampClock {
+  public:
+    static std::uint64_t Now() {
+#if defined(__x86_64__) || defined(__i386__)
+        if (sUseTsc)
+            return __rdtsc();
+#endif
+        auto cSinceEpoch  = std::chrono::steady_clock::now().time_since_epoch();
+        auto cNanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(cSinceEpoch);
+        return static_cast<std::uint64_t>(cNanoseconds.count());
+    }
+
+    static bool Is_Tsc() { return sUseTsc; }
+
+    // Calibrated against steady_clock on first use (spins for ~10ms)
+    static double Nanoseconds_Per_Tick() {
+        static const double sNanosecondsPerTick = sUseTsc ? Calibrate() : 1.0;
+        return sNanosecondsPerTick;
+    }
+
+  private:
+    static bool Has_Invariant_Tsc() {
+#if defined(__x86_64__) || defined(__i386__)
+        unsigned int cEax = 0, cEbx = 0, cEcx = 0, cEdx = 0;
+        if (__get_cpuid(0x80000007, &cEax, &cEbx, &cEcx, &cEdx) == 0)
+            return false;
+        return (cEdx & (1u << 8)) != 0;  // Invariant TSC
+#else
+        return false;
+#endif
+    }
+
+    static double Calibrate() {
+        using Clock = std::chrono::steady_clock;
+
+        auto cStartTime  = Clock::now();
+        auto cStartTicks = Now();
+        while (Clock::now() - cStartTime < std::chrono::milliseconds(10))
+            ;
+        auto cTicks   = Now() - cStartTicks;
+        auto cElapsed = std::chrono::duration<double, std::nano>(Clock::now() - cStartTime);
+        return cElapsed.count() / static_cast<double>(cTicks);
+    }
+
+    inline static const bool sUseTsc = Has_Invariant_Tsc();
+};
+
+// Log-linear (HDR-style) histogram: values below 2^sSubBucketBits are recorded exactly, and each
+// power of two above that is split into 2^sSubBucketBits linear sub-buckets, so any value is
+// recorded with at most 1/2^sSubBucketBits (~6%) relative error, from 0 up to 2^64 - 1, in a
+// fixed array (no allocation, no resizing on the hot path).
+//
+// Single writer: Record() may only be called from one thread. The counts are atomics updated
+// with a relaxed load and store (no read-modify-write), so a monitoring thread can read
+// percentiles at any time. Those reads see each bucket individually: not a consistent cut.
+class LatencyHistogram {
+  public:
+    static constexpr int sSubBucketBits = 4;
+    static constexpr int sSubBuckets    = 1 << sSubBucketBits;
+    static constexpr int sNumBuckets    = (64 - sSubBucketBits + 1) * sSubBuckets;
+
+    // Writer thread
+    void Record(std::uint64_t aValue) {
+        Add(mCounts[Bucket_Index(aValue)], 1);
+        Add(mCount, 1);
+        if (aValue > mMax.load(std::memory_order::relaxed))
+            mMax.store(aValue, std::memory_order::relaxed);
+    }
+
+    // Any thread
+    std::uint64_t count() const { return mCount.load(std::memory_order::relaxed); }
+    std::uint64_t max() const { return mMax.load(std::memory_order::relaxed); }
+
+    // Upper bound of the bucket holding the value at aFraction (e.g. 0.99) of the recorded ones
+    std::uint64_t Percentile(double aFraction) const {
+        std::array<std::uint64_t, sNumBuckets> cCounts;
+        std::uint64_t                          cTotal = 0;
+        for (int cBucket = 0; cBucket < sNumBuckets; ++cBucket) {
+            cCounts[cBucket] = mCounts[cBucket].load(std::memory_order::relaxed);
+            cTotal += cCounts[cBucket];
+        }
+        if (cTotal == 0)
+            return 0;
+
+        auto          cRank       = static_cast<std::uint64_t>(aFraction * cTotal);
+        std::uint64_t cCumulative = 0;
+        for (int cBucket = 0; cBucket < sNumBuckets; ++cBucket) {
+            cCumulative += cCounts[cBucket];
+            if (cCumulative > cRank)
+                return std::min(Bucket_Upper_Bound(cBucket), max());
+        }
+        return max();
+    }
+
+    static int Bucket_Index(std::uint64_t aValue) {
+        if (aValue < sSubBuckets)
+            return static_cast<int>(aValue);
+
+        // Top sSubBucketBits + 1 bits select the sub-bucket within the power of two
+        auto cShift = std::bit_width(aValue) - 1 - sSubBucketBits;
+        auto cSub   = static_cast<int>(aValue >> cShift) - sSubBuckets;
+        return (cShift + 1) * sSubBuckets + cSub;
+    }
+
+    static std::uint64_t Bucket_Upper_Bound(int aBucket) {
+        auto cGroup = aBucket / sSubBuckets;
+        auto cSub   = static_cast<std::uint64_t>(aBucket % sSubBuckets);
+        if (cGroup == 0)
+            return cSub;
+        auto cShift = cGroup - 1;
+        auto cLower = (sSubBuckets + cSub) << cShift;
+        return cLower + ((std::uint64_t{1} << cShift) - 1);
+    }
+
+  private:
+    static void Add(std::atomic<std::uint64_t>& aCounter, std::uint64_t aAmount) {
+        auto cValue = aCounter.load(std::memory_order::relaxed);
+        aCounter.store(cValue + aAmount, std::memory_order::relaxed);
+    }
+
+    std::array<std::atomic<std::uint64_t>, sNumBuckets> mCounts = {};
+    std::atomic<std::uint64_t>                          mCount{0};
+    std::atomic<std::uint64_t>                          mMax{0};
+};
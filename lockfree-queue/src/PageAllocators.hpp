@@ -0,0 +1,215 @@
+#pragma once
+
+#include <linux/mempolicy.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+
+#include "common.hpp"
+
+// Production allocators for queue storage, satisfying the QueueAllocator contract (common.hpp).
+// Both map whole pages straight from the kernel (so multi-MB rings never go through malloc),
+// optionally prefault them so the first pushes don't take page faults, and remember each
+// mapping's length for Free().
+
+// Bookkeeping for page-granular mappings
+class PageMappings {
+  public:
+    PageMappings() = default;
+    ~PageMappings() {
+        // Clean up any remaining mappings
+        for (auto [cAddress, cNumBytes] : mMappings)
+            munmap(cAddress, cNumBytes);
+    }
+
+    PageMappings(const PageMappings&)            = delete;
+    PageMappings& operator=(const PageMappings&) = delete;
+
+    static std::size_t Page_Size() { return static_cast<std::size_t>(sysconf(_SC_PAGESIZE)); }
+
+    static std::size_t Round_Up(std::size_t aNumBytes, std::size_t aMultiple) {
+        return ((aNumBytes + aMultiple - 1) / aMultiple) * aMultiple;
+    }
+
+    // Maps aNumBytes (a multiple of the page size) aligned to aAlignment, nullptr on failure
+    std::byte* Map(std::size_t aNumBytes, std::size_t aAlignment, int aExtraFlags = 0) {
+        // Over-map, then trim both ends to get the requested alignment. Not for hugetlb mappings:
+        // they are already huge page aligned, and over-mapping would reserve an extra huge page.
+        auto cAlignment = std::max(aAlignment, Page_Size());
+        bool cIsTrimmed = (cAlignment > Page_Size()) && ((aExtraFlags & MAP_HUGETLB) == 0);
+        auto cMapBytes  = aNumBytes + (cIsTrimmed ? cAlignment : 0);
+        auto cFlags     = MAP_PRIVATE | MAP_ANONYMOUS | aExtraFlags;
+        auto cMapped    = mmap(nullptr, cMapBytes, PROT_READ | PROT_WRITE, cFlags, -1, 0);
+        if (cMapped == MAP_FAILED)
+            return nullptr;
+
+        auto cBegin   = reinterpret_cast<std::uintptr_t>(cMapped);
+        auto cAligned = Round_Up(cBegin, cAlignment);
+        if (cAligned > cBegin)
+            munmap(cMapped, cAligned - cBegin);
+        auto cTail = (cBegin + cMapBytes) - (cAligned + aNumBytes);
+        if (cTail > 0)
+            munmap(reinterpret_cast<void*>(cAligned + aNumBytes), cTail);
+
+        auto cAddress = reinterpret_cast<std::byte*>(cAligned);
+        mMappings.emplace(cAddress, aNumBytes);
+        return cAddress;
+    }
+
+    void Unmap(std::byte* aAddress) {
+        auto cIter = mMappings.find(aAddress);
+        if (cIter == mMappings.end())
+            return;
+        munmap(cIter->first, cIter->second);
+        mMappings.erase(cIter);
+    }
+
+    // Touches every page so it is backed (and placed) now rather than on the hot path
+    static void Prefault(std::byte* aAddress, std::size_t aNumBytes) {
+        auto cPageSize = Page_Size();
+        for (std::size_t cOffset = 0; cOffset < aNumBytes; cOffset += cPageSize)
+            reinterpret_cast<volatile std::byte*>(aAddress)[cOffset] = std::byte{0};
+    }
+
+    size_t size() const { return mMappings.size(); }
+
+  private:
+    std::unordered_map<std::byte*, std::size_t> mMappings;
+};
+
+// Huge page backed allocator: one TLB entry covers 2 MiB of the ring instead of 4 KiB.
+// Explicit mode takes pages from the hugetlbfs pool (vm.nr_hugepages), falling back to
+// transparent huge pages when the pool is exhausted. Transparent mode asks khugepaged for huge
+// pages with madvise(MADV_HUGEPAGE), which works with THP set to "always" or "madvise".
+enum class HugePages { Transparent = 0, Explicit };
+
+class HugePageAllocator {
+  public:
+    static constexpr std::size_t sHugePageSize = 2 * 1024 * 1024;  // x86-64 and arm64 default
+
+    explicit HugePageAllocator(HugePages aMode = HugePages::Transparent, bool aPrefault = true)
+        : mMode(aMode), mPrefault(aPrefault) {}
+
+    std::byte* Allocate(size_t aSize, size_t aAlignment) {
+        Assert(aAlignment <= sHugePageSize, "Alignment {} exceeds the huge page size!\n",
+               aAlignment);
+        auto cNumBytes = PageMappings::Round_Up(aSize, sHugePageSize);
+
+        if (mMode == HugePages::Explicit) {
+            auto cFlags   = MAP_HUGETLB | (mPrefault ? MAP_POPULATE : 0);
+            auto cAddress = mMappings.Map(cNumBytes, sHugePageSize, cFlags);
+            if (cAddress != nullptr)
+                return cAddress;
+            ++mNumFallbacks;  // The hugetlbfs pool is empty (or not configured)
+        }
+
+        auto cAddress = mMappings.Map(cNumBytes, sHugePageSize);
+        if (cAddress == nullptr)
+            throw std::bad_alloc();
+        madvise(cAddress, cNumBytes, MADV_HUGEPAGE);  // Advisory: failure just means 4 KiB pages
+        if (mPrefault)
+            PageMappings::Prefault(cAddress, cNumBytes);
+        return cAddress;
+    }
+
+    void Free(std::byte* ptr) {
+        if (ptr)
+            mMappings.Unmap(ptr);
+    }
+
+    size_t allocated_count() const { return mMappings.size(); }
+
+    // Explicit mode allocations that had to fall back to transparent huge pages
+    size_t fallback_count() const { return mNumFallbacks; }
+
+  private:
+    PageMappings mMappings;
+    HugePages    mMode;
+    bool         mPrefault;
+    size_t       mNumFallbacks = 0;
+};
+
+// NUMA-local allocator: binds the pages to one node with mbind(MPOL_BIND), so the ring lives on
+// the socket of the threads using it. Prefaulting places the pages immediately, instead of on
+// the first touch by whichever thread gets there first. Uses the raw syscall: no libnuma needed.
+class NumaAllocator {
+    static constexpr int  sMaxNodes    = 1024;
+    static constexpr auto sBitsPerWord = 8 * sizeof(unsigned long);
+
+  public:
+    explicit NumaAllocator(int aNode, bool aPrefault = true, bool aHugePages = false)
+        : mNode(aNode), mPrefault(aPrefault), mHugePages(aHugePages) {
+        if (!Is_Node_Online(aNode))
+            throw std::invalid_argument("NUMA node " + std::to_string(aNode) + " doesn't exist");
+        mNodeMask[aNode / sBitsPerWord] = 1UL << (aNode % sBitsPerWord);
+    }
+
+    static bool Is_Node_Online(int aNode) {
+        if ((aNode < 0) || (aNode >= sMaxNodes))
+            return false;
+        auto cPath = "/sys/devices/system/node/node" + std::to_string(aNode);
+        return std::filesystem::exists(cPath);
+    }
+
+    static int Num_Nodes() {
+        int cNumNodes = 0;
+        for (int cNode = 0; cNode < sMaxNodes; ++cNode)
+            cNumNodes += Is_Node_Online(cNode) ? 1 : 0;
+        return std::max(cNumNodes, 1);  // No sysfs node directory: not a NUMA system
+    }
+
+    std::byte* Allocate(size_t aSize, size_t aAlignment) {
+        auto cGranularity =
+            mHugePages ? HugePageAllocator::sHugePageSize : PageMappings::Page_Size();
+        auto cNumBytes = PageMappings::Round_Up(aSize, cGranularity);
+        auto cAddress  = mMappings.Map(cNumBytes, std::max(aAlignment, cGranularity));
+        if (cAddress == nullptr)
+            throw std::bad_alloc();
+        if (mHugePages)
+            madvise(cAddress, cNumBytes, MADV_HUGEPAGE);
+
+        // Bind before the first touch, so no page is ever placed elsewhere
+        auto cMaxNode = sMaxNodes + 1;  // The kernel ignores the last bit
+        if (syscall(SYS_mbind, cAddress, cNumBytes, MPOL_BIND, mNodeMask.data(), cMaxNode,
+                    MPOL_MF_STRICT | MPOL_MF_MOVE) != 0) {
+            auto cError = errno;
+            mMappings.Unmap(cAddress);
+            throw std::system_error(cError, std::generic_category(), "mbind");
+        }
+
+        if (mPrefault)
+            PageMappings::Prefault(cAddress, cNumBytes);
+        return cAddress;
+    }
+
+    void Free(std::byte* ptr) {
+        if (ptr)
+            mMappings.Unmap(ptr);
+    }
+
+    size_t allocated_count() const { return mMappings.size(); }
+    int    node() const { return mNode; }
+
+  private:
+    PageMappings mMappings;
+    int          mNode;
+    bool         mPrefault;
+    bool         mHugePages;
+
+    std::array<unsigned long, sMaxNodes / sBitsPerWord> mNodeMask = {};
+};
+
+static_assert(QueueAllocator<HugePageAllocator>);
+static_assert(QueueAllocator<NumaAllocator>);
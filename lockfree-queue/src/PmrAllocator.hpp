@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+
+#include "common.hpp"
+
+// Adapts a std::pmr::memory_resource to the QueueAllocator contract (common.hpp), so queue
+// storage can come from a monotonic buffer carved out at startup, a pool resource, or any custom
+// resource. memory_resource::deallocate() needs the original size and alignment, so this uses
+// the sized Free(), which Queue::Free() calls with the same values it passed to Allocate().
+// The resource isn't owned, and must outlive the queues allocated from it.
+class PmrAllocator {
+  public:
+    explicit PmrAllocator(std::pmr::memory_resource* aResource = std::pmr::get_default_resource())
+        : mResource(aResource) {
+        Assert(mResource != nullptr, "Null memory resource!\n");
+    }
+
+    std::byte* Allocate(std::size_t aSize, std::size_t aAlignment) {
+        return static_cast<std::byte*>(mResource->allocate(aSize, aAlignment));
+    }
+
+    void Free(std::byte* aStorage, std::size_t aSize, std::size_t aAlignment) {
+        if (aStorage)
+            mResource->deallocate(aStorage, aSize, aAlignment);
+    }
+
+    std::pmr::memory_resource* resource() const { return mResource; }
+
+  private:
+    std::pmr::memory_resource* mResource;
+};
+
+static_assert(QueueAllocator<PmrAllocator>);
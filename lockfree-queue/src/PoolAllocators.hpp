@@ -0,0 +1,201 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+#include "common.hpp"
+
+// Allocators for creating and destroying many (small, short-lived) queues, satisfying the
+// QueueAllocator contract (common.hpp). Both use the sized Free(), so freeing never has to look
+// the block up: it's O(1) rather than a search over every live allocation. Neither is
+// thread-safe: create and free the queues from one thread (or guard the allocator).
+
+// Slab allocator: power-of-two size classes from one cache line up to sMaxBlockSize, each with an
+// intrusive free list of blocks carved out of larger slabs. Freed blocks are reused by the next
+// queue of the same size class, so steady-state churn never reaches malloc. Bigger (or
+// over-aligned) requests go straight to aligned_alloc.
+class SlabAllocator {
+  public:
+    static constexpr std::size_t sBlockAlign   = hardware_destructive_interference_size;
+    static constexpr std::size_t sMinBlockSize = sBlockAlign;
+    static constexpr std::size_t sMaxBlockSize = 1024 * 1024;
+    static constexpr std::size_t sSlabSize     = 256 * 1024;  // Blocks carved out at a time
+
+    SlabAllocator() = default;
+    ~SlabAllocator() {
+        for (auto cSlab : mSlabs)
+            std::free(cSlab);
+    }
+
+    SlabAllocator(const SlabAllocator&)            = delete;
+    SlabAllocator& operator=(const SlabAllocator&) = delete;
+
+    std::byte* Allocate(std::size_t aSize, std::size_t aAlignment) {
+        if (Is_Large(aSize, aAlignment)) {
+            auto cStorage = Allocate_Large(aSize, aAlignment);
+            ++mNumAllocated;
+            return cStorage;
+        }
+
+        auto  cClass = Size_Class(aSize);
+        auto& cHead  = mFreeLists[cClass];
+        if (cHead == nullptr)
+            Carve_Slab(cClass);
+
+        auto cBlock = cHead;
+        cHead       = cBlock->mNext;
+        ++mNumAllocated;
+        return reinterpret_cast<std::byte*>(cBlock);
+    }
+
+    void Free(std::byte* aStorage, std::size_t aSize, std::size_t aAlignment) {
+        if (aStorage == nullptr)
+            return;
+        --mNumAllocated;
+        if (Is_Large(aSize, aAlignment)) {
+            std::free(aStorage);
+            return;
+        }
+
+        auto& cHead = mFreeLists[Size_Class(aSize)];
+        cHead       = ::new (aStorage) FreeBlock{cHead};
+    }
+
+    size_t allocated_count() const { return mNumAllocated; }
+    size_t slab_count() const { return mSlabs.size(); }
+
+  private:
+    struct FreeBlock {
+        FreeBlock* mNext;
+    };
+
+    static constexpr auto sNumClasses =
+        std::countr_zero(sMaxBlockSize) - std::countr_zero(sMinBlockSize) + 1;
+
+    static bool Is_Large(std::size_t aSize, std::size_t aAlignment) {
+        return (aSize > sMaxBlockSize) || (aAlignment > sBlockAlign);
+    }
+
+    static int Size_Class(std::size_t aSize) {
+        auto cBlockSize = std::bit_ceil(std::max(aSize, sMinBlockSize));
+        return std::countr_zero(cBlockSize) - std::countr_zero(sMinBlockSize);
+    }
+
+    static std::byte* Allocate_Large(std::size_t aSize, std::size_t aAlignment) {
+        auto cNumBytes = ((aSize + aAlignment - 1) / aAlignment) * aAlignment;
+        auto cStorage  = std::aligned_alloc(aAlignment, cNumBytes);
+        if (cStorage == nullptr)
+            throw std::bad_alloc();
+        return static_cast<std::byte*>(cStorage);
+    }
+
+    // Threads a new slab's blocks onto the (empty) free list of the size class
+    void Carve_Slab(int aClass) {
+        auto cBlockSize = sMinBlockSize << aClass;
+        auto cSlabSize  = std::max(sSlabSize, cBlockSize);
+        auto cSlab      = static_cast<std::byte*>(std::aligned_alloc(sBlockAlign, cSlabSize));
+        if (cSlab == nullptr)
+            throw std::bad_alloc();
+        mSlabs.push_back(cSlab);
+
+        auto& cHead = mFreeLists[aClass];
+        for (auto cOffset = cSlabSize; cOffset >= cBlockSize; cOffset -= cBlockSize)
+            cHead = ::new (cSlab + cOffset - cBlockSize) FreeBlock{cHead};
+    }
+
+    std::array<FreeBlock*, sNumClasses> mFreeLists    = {};
+    std::vector<std::byte*>             mSlabs;
+    size_t                              mNumAllocated = 0;
+};
+
+// Bump-pointer arena: allocating just advances an offset into the current chunk, and freeing only
+// counts. Once every queue allocated from the arena has been freed, it rewinds to the start and
+// reuses its chunks, so create-all/destroy-all cycles (e.g. per session) cost no system calls
+// after the first. Memory isn't reused until then: not for long-lived queues mixed with churn.
+class ArenaAllocator {
+  public:
+    static constexpr std::size_t sChunkAlign = hardware_destructive_interference_size;
+
+    explicit ArenaAllocator(std::size_t aChunkSize = 1024 * 1024) : mChunkSize(aChunkSize) {}
+    ~ArenaAllocator() {
+        for (auto& cChunk : mChunks)
+            std::free(cChunk.mBegin);
+    }
+
+    ArenaAllocator(const ArenaAllocator&)            = delete;
+    ArenaAllocator& operator=(const ArenaAllocator&) = delete;
+
+    std::byte* Allocate(std::size_t aSize, std::size_t aAlignment) {
+        auto cStorage = Bump(aSize, aAlignment);
+        if (cStorage == nullptr) {
+            // Move on to the next chunk, adding one if there is none (or it's too small)
+            mOffset = 0;
+            if (!mChunks.empty())
+                ++mChunk;
+            if ((mChunk == mChunks.size()) || (mChunks[mChunk].mNumBytes < aSize + aAlignment))
+                Insert_Chunk(aSize + aAlignment);
+            cStorage = Bump(aSize, aAlignment);
+        }
+
+        ++mNumAllocated;
+        return cStorage;
+    }
+
+    void Free(std::byte* aStorage, std::size_t, std::size_t) {
+        if (aStorage == nullptr)
+            return;
+        if (--mNumAllocated == 0) {
+            mChunk  = 0;  // Everything is free: rewind
+            mOffset = 0;
+        }
+    }
+
+    size_t allocated_count() const { return mNumAllocated; }
+    size_t chunk_count() const { return mChunks.size(); }
+
+  private:
+    struct Chunk {
+        std::byte*  mBegin;
+        std::size_t mNumBytes;
+    };
+
+    // Carves from the current chunk, nullptr if it doesn't fit
+    std::byte* Bump(std::size_t aSize, std::size_t aAlignment) {
+        if (mChunk >= mChunks.size())
+            return nullptr;
+
+        auto& cChunk   = mChunks[mChunk];
+        auto  cBegin   = reinterpret_cast<std::uintptr_t>(cChunk.mBegin);
+        auto  cAligned = ((cBegin + mOffset + aAlignment - 1) / aAlignment) * aAlignment;
+        auto  cEnd     = cAligned + aSize;
+        if (cEnd > cBegin + cChunk.mNumBytes)
+            return nullptr;
+
+        mOffset = cEnd - cBegin;
+        return reinterpret_cast<std::byte*>(cAligned);
+    }
+
+    void Insert_Chunk(std::size_t aMinSize) {
+        auto cNumBytes = std::max(mChunkSize, aMinSize);
+        cNumBytes      = ((cNumBytes + sChunkAlign - 1) / sChunkAlign) * sChunkAlign;
+        auto cBegin    = static_cast<std::byte*>(std::aligned_alloc(sChunkAlign, cNumBytes));
+        if (cBegin == nullptr)
+            throw std::bad_alloc();
+        mChunks.insert(mChunks.begin() + mChunk, Chunk{cBegin, cNumBytes});
+    }
+
+    std::vector<Chunk> mChunks;
+    std::size_t        mChunkSize;
+    std::size_t        mChunk        = 0;  // Index of the chunk being carved
+    std::size_t        mOffset       = 0;  // Into the current chunk
+    size_t             mNumAllocated = 0;
+};
+
+static_assert(QueueAllocator<SlabAllocator>);
+static_assert(QueueAllocator<ArenaAllocator>);
@@ -0,0 +1,195 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "LatencyHistogram.hpp"
+#include "common.hpp"
+
+// Snapshot of a queue's operation counters (StatsPolicy::Counters)
+struct QueueStats {
+    // Producer side
+    std::uint64_t pushes           = 0;  // Items pushed
+    std::uint64_t full_rejections  = 0;  // Pushes that found the queue full
+    std::uint64_t push_waits       = 0;  // Times the producer waited for space
+    std::uint64_t consumer_wakeups = 0;  // Notifies sent to wake a waiting consumer
+    std::uint64_t high_water_mark  = 0;  // Max occupancy seen after a push
+
+    // Consumer side
+    std::uint64_t pops             = 0;  // Items popped
+    std::uint64_t empty_rejections = 0;  // Pops that found the queue empty
+    std::uint64_t pop_waits        = 0;  // Times the consumer waited for items
+    std::uint64_t producer_wakeups = 0;  // Notifies sent to wake a waiting producer
+};
+
+// Push-to-pop latency percentiles (StatsPolicy::Latency), in nanoseconds
+struct LatencySummary {
+    std::uint64_t count = 0;  // Items traced
+    double        p50   = 0;
+    double        p99   = 0;
+    double        p999  = 0;
+    double        max   = 0;
+};
+
+// Counters for StatsPolicy::Counters. Each side's counters are written only by that side's thread,
+// and live on their own cache line(s) so counting doesn't add traffic between the two threads.
+// With a single writer no read-modify-write is needed: a relaxed load and store compile to the
+// same plain add as a non-atomic counter, while still letting a monitoring thread read them.
+class QueueCounters {
+    using Counter = std::atomic<std::uint64_t>;
+
+  public:
+    // Producer side
+    void Pushed(int aNumPushed) { Add(mProducer.pushes, aNumPushed); }
+    void Push_Rejected() { Add(mProducer.full_rejections, 1); }
+    void Push_Waiting() { Add(mProducer.push_waits, 1); }
+    void Woke_Consumer() { Add(mProducer.consumer_wakeups, 1); }
+    void Occupancy(int aSize) {
+        auto cSize = static_cast<std::uint64_t>(aSize);
+        if (cSize > mProducer.high_water_mark.load(std::memory_order::relaxed))
+            mProducer.high_water_mark.store(cSize, std::memory_order::relaxed);
+    }
+
+    // Consumer side
+    void Popped(int aNumPopped) { Add(mConsumer.pops, aNumPopped); }
+    void Pop_Rejected() { Add(mConsumer.empty_rejections, 1); }
+    void Pop_Waiting() { Add(mConsumer.pop_waits, 1); }
+    void Woke_Producer() { Add(mConsumer.producer_wakeups, 1); }
+
+    // Any thread. The counters are read individually: not a consistent cut across them.
+    QueueStats Snapshot() const {
+        static constexpr auto sOrder = std::memory_order::relaxed;
+
+        QueueStats cStats;
+        cStats.pushes           = mProducer.pushes.load(sOrder);
+        cStats.full_rejections  = mProducer.full_rejections.load(sOrder);
+        cStats.push_waits       = mProducer.push_waits.load(sOrder);
+        cStats.consumer_wakeups = mProducer.consumer_wakeups.load(sOrder);
+        cStats.high_water_mark  = mProducer.high_water_mark.load(sOrder);
+        cStats.pops             = mConsumer.pops.load(sOrder);
+        cStats.empty_rejections = mConsumer.empty_rejections.load(sOrder);
+        cStats.pop_waits        = mConsumer.pop_waits.load(sOrder);
+        cStats.producer_wakeups = mConsumer.producer_wakeups.load(sOrder);
+        return cStats;
+    }
+
+  private:
+    static void Add(Counter& aCounter, std::uint64_t aAmount) {
+        auto cValue = aCounter.load(std::memory_order::relaxed);
+        aCounter.store(cValue + aAmount, std::memory_order::relaxed);
+    }
+
+    struct alignas(hardware_destructive_interference_size) ProducerCounters {
+        Counter pushes{0};
+        Counter full_rejections{0};
+        Counter push_waits{0};
+        Counter consumer_wakeups{0};
+        Counter high_water_mark{0};
+    };
+
+    struct alignas(hardware_destructive_interference_size) ConsumerCounters {
+        Counter pops{0};
+        Counter empty_rejections{0};
+        Counter pop_waits{0};
+        Counter producer_wakeups{0};
+    };
+
+    ProducerCounters mProducer;
+    ConsumerCounters mConsumer;
+};
+
+// StatsPolicy::None: same interface, but empty, so every call compiles away
+class NoQueueCounters {
+  public:
+    void Pushed(int) {}
+    void Push_Rejected() {}
+    void Push_Waiting() {}
+    void Woke_Consumer() {}
+    void Occupancy(int) {}
+
+    void Popped(int) {}
+    void Pop_Rejected() {}
+    void Pop_Waiting() {}
+    void Woke_Producer() {}
+};
+
+// Tracer for StatsPolicy::Latency: a timestamp column parallel to the queue's slots, written by
+// the producer as it pushes and read by the consumer as it pops. The timestamps are published and
+// consumed with the slots themselves (by the push/pop index release/acquire), so they need no
+// synchronization of their own. The histogram is written only by the consumer.
+class QueueLatencyTracer {
+  public:
+    template <QueueAllocator AllocatorType>
+    void Allocate(AllocatorType& aAllocator, int aCapacity) {
+        auto cNumBytes = aCapacity * sizeof(std::uint64_t);
+        auto cStorage  = aAllocator.Allocate(cNumBytes, sAlign);
+        Assert(cStorage != nullptr, "Memory allocation failed!\n");
+        mTimestamps = reinterpret_cast<std::uint64_t*>(cStorage);
+    }
+
+    template <QueueAllocator AllocatorType>
+    void Free(AllocatorType& aAllocator, int aCapacity) {
+        auto cStorage = reinterpret_cast<std::byte*>(mTimestamps);
+        Free_Storage(aAllocator, cStorage, aCapacity * sizeof(std::uint64_t), sAlign);
+        mTimestamps = nullptr;
+    }
+
+    // Producer: stamps aNumPushed slots starting at aIndex, before they are published
+    void Stamp(int aIndex, int aNumPushed, int aCapacity) {
+        auto cNow          = TimestampClock::Now();
+        auto cInitialCount = std::min(aNumPushed, aCapacity - aIndex);
+        std::fill_n(mTimestamps + aIndex, cInitialCount, cNow);
+        std::fill_n(mTimestamps, aNumPushed - cInitialCount, cNow);
+    }
+
+    // Consumer: records the latency of aNumPopped slots starting at aIndex
+    void Record(int aIndex, int aNumPopped, int aCapacity) {
+        auto cNow          = TimestampClock::Now();
+        auto cInitialCount = std::min(aNumPopped, aCapacity - aIndex);
+        for (int cSlot = aIndex; cSlot < aIndex + cInitialCount; ++cSlot)
+            mHistogram.Record(Elapsed(mTimestamps[cSlot], cNow));
+        for (int cSlot = 0; cSlot < aNumPopped - cInitialCount; ++cSlot)
+            mHistogram.Record(Elapsed(mTimestamps[cSlot], cNow));
+    }
+
+    // Any thread. Histogram values are in TimestampClock ticks.
+    const LatencyHistogram& histogram() const { return mHistogram; }
+
+    LatencySummary Summary() const {
+        auto cNanosecondsPerTick = TimestampClock::Nanoseconds_Per_Tick();
+
+        LatencySummary cSummary;
+        cSummary.count = mHistogram.count();
+        cSummary.p50   = mHistogram.Percentile(0.5) * cNanosecondsPerTick;
+        cSummary.p99   = mHistogram.Percentile(0.99) * cNanosecondsPerTick;
+        cSummary.p999  = mHistogram.Percentile(0.999) * cNanosecondsPerTick;
+        cSummary.max   = mHistogram.max() * cNanosecondsPerTick;
+        return cSummary;
+    }
+
+  private:
+    static constexpr auto sAlign = hardware_destructive_interference_size;
+
+    // Clamped: the TSCs of different cores may be skewed by a few ticks
+    static std::uint64_t Elapsed(std::uint64_t aStart, std::uint64_t aEnd) {
+        return (aEnd > aStart) ? (aEnd - aStart) : 0;
+    }
+
+    std::uint64_t* mTimestamps = nullptr;  // Never changes while in use: no padding needed
+
+    alignas(sAlign) LatencyHistogram mHistogram;
+};
+
+// StatsPolicy without Latency: same interface, but empty, so every call compiles away
+class NoQueueLatencyTracer {
+  public:
+    template <typename AllocatorType>
+    void Allocate(AllocatorType&, int) {}
+    template <typename AllocatorType>
+    void Free(AllocatorType&, int) {}
+
+    void Stamp(int, int, int) {}
+    void Record(int, int, int) {}
+};
@@ -16,6 +16,8 @@
  * limitations under the License.
  */
 
+#pragma once
+
 #include <algorithm>
 #include <atomic>
 #include <iterator>
@@ -23,16 +25,21 @@
 #include <memory>
 #include <new>
 #include <span>
+#include <type_traits>
 
+#include "QueueStats.hpp"
 #include "common.hpp"
 
-template <typename DataType, WaitPolicy Waiting>
-class Queue<DataType, ThreadsPolicy::SPSC, Waiting> {
+template <typename DataType, WaitPolicy Waiting, StatsPolicy Stats>
+class Queue<DataType, ThreadsPolicy::SPSC, Waiting, Stats> {
     // CONSTEXPR MEMBERS (needed for requires clauses)
-    static constexpr bool sPushAwait = Await_Pushes(Waiting);
-    static constexpr bool sPopAwait  = Await_Pops(Waiting);
+    static constexpr bool sPushAwait     = Await_Pushes(Waiting);
+    static constexpr bool sPopAwait      = Await_Pops(Waiting);
+    static constexpr bool sTrackCounters = Track_Counters(Stats);
+    static constexpr bool sTrackLatency  = Track_Latency(Stats);
     static constexpr int  sSizeMask  = 0x80000000;  // ASSUMES 32 BIT int!
     static constexpr auto sAlign     = hardware_destructive_interference_size;
+    static constexpr auto sAlignment = std::max(sAlign, alignof(DataType));
 
   public:
     // Constructor/Destructor
@@ -41,17 +48,18 @@ class Queue<DataType, ThreadsPolicy::SPSC, Waiting> {
 
     // Memory management
 
-    template <typename AllocatorType>
-    void Allocate(AllocatorType& aAllocator, int aCapacity) {
+    // Default capacity: fits in half the L2 cache
+    template <QueueAllocator AllocatorType>
+    void Allocate(AllocatorType& aAllocator, int aCapacity = Default_Capacity(sizeof(DataType))) {
         Assert(!Is_Allocated(), "Can't allocate while still owning memory!\n");
         Assert(aCapacity > 0, "Invalid capacity {}!\n", aCapacity);
 
         // Allocate memory for object storage
-        auto                  cNumBytes  = aCapacity * sizeof(DataType);
-        static constexpr auto sAlignment = std::max(sAlign, alignof(DataType));
-        mStorage                         = aAllocator.Allocate(cNumBytes, sAlignment);
+        auto cNumBytes = aCapacity * sizeof(DataType);
+        mStorage       = aAllocator.Allocate(cNumBytes, sAlignment);
         Assert(mStorage != nullptr, "Memory allocation failed!\n");
         mCapacity = aCapacity;
+        mLatency.Allocate(aAllocator, aCapacity);
 
         // Calculate where index values will wrap-around to zero
         static constexpr auto sMaxValue          = std::numeric_limits<int>::max();
@@ -62,12 +70,13 @@ class Queue<DataType, ThreadsPolicy::SPSC, Waiting> {
 
     bool Is_Allocated() const { return (mStorage != nullptr); }
 
-    template <typename AllocatorType>
+    template <QueueAllocator AllocatorType>
     void Free(AllocatorType& aAllocator) {
         Assert(Is_Allocated(), "No memory to free!\n");
         Assert(empty(), "Can't free until empty!\n");
 
-        aAllocator.Free(mStorage);
+        Free_Storage(aAllocator, mStorage, mCapacity * sizeof(DataType), sAlignment);
+        mLatency.Free(aAllocator, mCapacity);
         mStorage  = nullptr;
         mCapacity = 0;
     }
@@ -82,13 +91,16 @@ class Queue<DataType, ThreadsPolicy::SPSC, Waiting> {
 
         // Guard against the container being full
         auto cIndexDelta = cUnwrappedPushIndex - cUnwrappedPopIndex;
-        if ((cIndexDelta == mCapacity) || (cIndexDelta == (mCapacity - mIndexEnd)))
+        if ((cIndexDelta == mCapacity) || (cIndexDelta == (mCapacity - mIndexEnd))) {
+            mStats.Push_Rejected();
             return false;  // Full. The second check handled wrap-around
+        }
 
         // Emplace the object
         auto cPushIndex = cUnwrappedPushIndex % mCapacity;
         auto cAddress   = mStorage + cPushIndex * sizeof(DataType);
         new (cAddress) DataType(std::forward<ArgumentTypes>(aArguments)...);
+        mLatency.Stamp(cPushIndex, 1, mCapacity);
 
         // Advance push index
         auto cNewPushIndex = Bump_Index(cUnwrappedPushIndex);
@@ -97,6 +109,7 @@ class Queue<DataType, ThreadsPolicy::SPSC, Waiting> {
 
         // Update the size
         Increase_Size(1);
+        mStats.Pushed(1);
         return true;
     }
 
@@ -108,8 +121,10 @@ class Queue<DataType, ThreadsPolicy::SPSC, Waiting> {
         auto cUnwrappedPopIndex = mPopIndex.value.load(std::memory_order::relaxed);
 
         // Guard against the container being empty
-        if (cUnwrappedPopIndex == cUnwrappedPushIndex)
+        if (cUnwrappedPopIndex == cUnwrappedPushIndex) {
+            mStats.Pop_Rejected();
             return false;  // The queue is empty
+        }
 
         // Pop data
         auto cPopIndex = cUnwrappedPopIndex % mCapacity;
@@ -117,6 +132,7 @@ class Queue<DataType, ThreadsPolicy::SPSC, Waiting> {
         auto cData     = std::launder(reinterpret_cast<DataType*>(cAddress));
         aPopped        = std::move(*cData);
         cData->~DataType();
+        mLatency.Record(cPopIndex, 1, mCapacity);
 
         // Advance pop index
         auto cNewPopIndex = Bump_Index(cUnwrappedPopIndex);
@@ -125,6 +141,7 @@ class Queue<DataType, ThreadsPolicy::SPSC, Waiting> {
 
         // Update the size
         Decrease_Size(1);
+        mStats.Popped(1);
         return true;
     }
 
@@ -142,8 +159,11 @@ class Queue<DataType, ThreadsPolicy::SPSC, Waiting> {
         cMaxSlotsAvailable -= (cMaxSlotsAvailable >= mIndexEnd) ? mIndexEnd : 0;
         const auto cSpanSize  = static_cast<int>(aSpan.size());
         auto       cNumToPush = std::min(cSpanSize, cMaxSlotsAvailable);
-        if (cNumToPush == 0)
+        if (cNumToPush == 0) {
+            if (cMaxSlotsAvailable == 0)
+                mStats.Push_Rejected();
             return aSpan;  // The queue is full.
+        }
 
         // Setup push
         auto       cPushIndex         = cUnwrappedPushIndex % mCapacity;
@@ -163,6 +183,7 @@ class Queue<DataType, ThreadsPolicy::SPSC, Waiting> {
             auto cToPush = cSpanData + cInitialLength;
             std::uninitialized_move_n(cToPush, cDistanceBeyondEnd, cPushToData);
         }
+        mLatency.Stamp(cPushIndex, cNumToPush, mCapacity);
 
         // Advance push index
         auto cNewPushIndex = Increase_Index(cUnwrappedPushIndex, cNumToPush);
@@ -171,6 +192,7 @@ class Queue<DataType, ThreadsPolicy::SPSC, Waiting> {
 
         // Update the size
         Increase_Size(cNumToPush);
+        mStats.Pushed(cNumToPush);
 
         // Return unfinished entries
         auto cRemainingBegin = cSpanData + cNumToPush;
@@ -190,8 +212,11 @@ class Queue<DataType, ThreadsPolicy::SPSC, Waiting> {
         cMaxSlotsAvailable += (cMaxSlotsAvailable < 0) ? mIndexEnd : 0;
         auto cOutputSpaceAvailable = static_cast<int>(aPopped.capacity() - aPopped.size());
         auto cNumToPop             = std::min(cOutputSpaceAvailable, cMaxSlotsAvailable);
-        if (cNumToPop == 0)
+        if (cNumToPop == 0) {
+            if (cMaxSlotsAvailable == 0)
+                mStats.Pop_Rejected();
             return;  // The queue is empty.
+        }
 
         // Helper function for Pop/destroy
         auto cPopAndDestroy = [&](DataType* aPopData, int aNumToPop) {
@@ -219,6 +244,7 @@ class Queue<DataType, ThreadsPolicy::SPSC, Waiting> {
             cPopFromData = std::launder(reinterpret_cast<DataType*>(mStorage));
             cPopAndDestroy(cPopFromData, cDistanceBeyondEnd);
         }
+        mLatency.Record(cPopIndex, cNumToPop, mCapacity);
 
         // Advance pop index
         auto cNewPopIndex = Increase_Index(cUnwrappedPopIndex, cNumToPop);
@@ -227,6 +253,7 @@ class Queue<DataType, ThreadsPolicy::SPSC, Waiting> {
 
         // Update the size
         Decrease_Size(cNumToPop);
+        mStats.Popped(cNumToPop);
     }
 
     template <typename... ArgumentTypes>
@@ -234,8 +261,10 @@ class Queue<DataType, ThreadsPolicy::SPSC, Waiting> {
         requires(sPushAwait)
     {
         // Acquire: Need sync to see the latest queue indices
-        while (!Emplace(std::forward<ArgumentTypes>(aArguments)...))
+        while (!Emplace(std::forward<ArgumentTypes>(aArguments)...)) {
+            mStats.Push_Waiting();
             mSize.value.wait(mCapacity, std::memory_order::acquire);
+        }
     }
 
     template <typename InputType>
@@ -248,6 +277,7 @@ class Queue<DataType, ThreadsPolicy::SPSC, Waiting> {
                 return;
 
             // Acquire: Need sync to see the latest queue indices
+            mStats.Push_Waiting();
             mSize.value.wait(mCapacity, std::memory_order::acquire);
         }
     }
@@ -261,6 +291,7 @@ class Queue<DataType, ThreadsPolicy::SPSC, Waiting> {
 
             // The queue was empty, wait until someone pushes or we're ending
             // Acquire: Need sync to see the latest queue indices
+            mStats.Pop_Waiting();
             mSize.value.wait(0, std::memory_order::acquire);
 
             // If mSize is sSizeMask then nothing will push, and none left to pop.
@@ -280,6 +311,7 @@ class Queue<DataType, ThreadsPolicy::SPSC, Waiting> {
                 return;
 
             // Comments are identical to Pop_Await()
+            mStats.Pop_Waiting();
             mSize.value.wait(0, std::memory_order::relaxed);
 
             // If mSize is sSizeMask then nothing will push, and none left to pop.
@@ -298,6 +330,26 @@ class Queue<DataType, ThreadsPolicy::SPSC, Waiting> {
 
     bool empty() const { return size() == 0; }
 
+    // Statistics: may be read from any thread
+    QueueStats stats() const
+        requires(sTrackCounters)
+    {
+        return mStats.Snapshot();
+    }
+
+    // Push-to-pop latency percentiles, in nanoseconds
+    LatencySummary latency() const
+        requires(sTrackLatency)
+    {
+        return mLatency.Summary();
+    }
+
+    const LatencyHistogram& latency_histogram() const
+        requires(sTrackLatency)
+    {
+        return mLatency.histogram();
+    }
+
     // Wait control
     void End_PopWaiting()
         requires(sPopAwait)
@@ -336,12 +388,15 @@ class Queue<DataType, ThreadsPolicy::SPSC, Waiting> {
         static constexpr auto sOrder =
             sPopAwait ? std::memory_order::release : std::memory_order::relaxed;
         [[maybe_unused]] auto cPriorSize = mSize.value.fetch_add(aNumPushed, sOrder);
+        mStats.Occupancy((cPriorSize & (~sSizeMask)) + aNumPushed);
 
         if constexpr (sPopAwait) {
             // If was empty, notify all threads
             // No need to clear high bit: if set, pop-waits already ended
-            if (cPriorSize == 0)
+            if (cPriorSize == 0) {
                 mSize.value.notify_all();
+                mStats.Woke_Consumer();
+            }
         }
     }
 
@@ -353,20 +408,26 @@ class Queue<DataType, ThreadsPolicy::SPSC, Waiting> {
 
         if constexpr (sPushAwait) {
             // If was full (clear the high bit!), notify all threads
-            if ((cPriorSize & (~sSizeMask)) == mCapacity)
+            if ((cPriorSize & (~sSizeMask)) == mCapacity) {
                 mSize.value.notify_all();
+                mStats.Woke_Producer();
+            }
         }
     }
 
     // OVER-ALIGNED MEMBERS
-    struct alignas(sAlign) PaddedAtomicInt {
-        std::atomic<int> value{0};
-    };
-
     PaddedAtomicInt mPushIndex;
     PaddedAtomicInt mPopIndex;
     PaddedAtomicInt mSize;
 
+    // Each side's counters are over-aligned. Empty (no storage) unless tracking counters.
+    using CountersType = std::conditional_t<sTrackCounters, QueueCounters, NoQueueCounters>;
+    [[no_unique_address]] CountersType mStats;
+
+    // Timestamp column and histogram. Empty (no storage) unless tracing latency.
+    using LatencyType = std::conditional_t<sTrackLatency, QueueLatencyTracer, NoQueueLatencyTracer>;
+    [[no_unique_address]] LatencyType mLatency;
+
     // DEFAULT-ALIGNED MEMBERS
     // Not over-aligned as neither these nor the mStorage pointer change
     std::byte* mStorage  = nullptr;  // Object Memory
@@ -374,5 +435,5 @@ class Queue<DataType, ThreadsPolicy::SPSC, Waiting> {
     int        mIndexEnd = 0;  // at this, we need to wrap indices around to zero
 };
 
-template <typename DataType, WaitPolicy Waiting>
-using SPSC = Queue<DataType, ThreadsPolicy::SPSC, Waiting>;
\ No newline at end of file
+template <typename DataType, WaitPolicy Waiting, StatsPolicy Stats = StatsPolicy::None>
+using SPSC = Queue<DataType, ThreadsPolicy::SPSC, Waiting, Stats>;
\ No newline at end of file
@@ -0,0 +1,374 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <limits>
+#include <span>
+#include <tuple>
+#include <type_traits>
+
+#include "common.hpp"
+
+// Structure-of-arrays variant of the SPSC ring.
+// Each field of a row lives in its own column ring, so a consumer that only needs a few fields
+// only streams those columns through the cache. Batched pops copy straight into caller-provided
+// column spans, ready to be handed to vectorized kernels.
+// Index, size and wait handling are identical to Queue<DataType, ThreadsPolicy::SPSC, Waiting>.
+template <typename... FieldTypes, WaitPolicy Waiting>
+class SoAQueue<std::tuple<FieldTypes...>, Waiting> {
+    static_assert(sizeof...(FieldTypes) > 0, "SoAQueue needs at least one field!");
+    static_assert((std::is_trivially_copyable_v<FieldTypes> && ...),
+                  "SoAQueue columns must be trivially copyable!");
+
+    // CONSTEXPR MEMBERS (needed for requires clauses)
+    static constexpr bool sPushAwait   = Await_Pushes(Waiting);
+    static constexpr bool sPopAwait    = Await_Pops(Waiting);
+    static constexpr int  sSizeMask    = 0x80000000;  // ASSUMES 32 BIT int!
+    static constexpr auto sAlign       = hardware_destructive_interference_size;
+    static constexpr auto sNumFields   = sizeof...(FieldTypes);
+    static constexpr auto sColumnAlign = std::max({sAlign, alignof(FieldTypes)...});
+
+  public:
+    using RowType = std::tuple<FieldTypes...>;
+
+    // Constructor/Destructor
+    SoAQueue()  = default;
+    ~SoAQueue() = default;
+
+    // Memory management
+
+    // Default capacity: all the columns fit in half the L2 cache
+    template <QueueAllocator AllocatorType>
+    void Allocate(AllocatorType& aAllocator,
+                  int aCapacity = Default_Capacity((sizeof(FieldTypes) + ...))) {
+        Assert(!Is_Allocated(), "Can't allocate while still owning memory!\n");
+        Assert(aCapacity > 0, "Invalid capacity {}!\n", aCapacity);
+
+        // One allocation, each column starting on its own cache line
+        std::array<std::size_t, sNumFields> cOffsets;
+        std::size_t                         cNumBytes = 0;
+        std::size_t                         cColumn   = 0;
+        ((cOffsets[cColumn++] = cNumBytes, cNumBytes += Round_Up(aCapacity * sizeof(FieldTypes))),
+         ...);
+
+        mStorage  = aAllocator.Allocate(cNumBytes, sColumnAlign);
+        mNumBytes = cNumBytes;
+        Assert(mStorage != nullptr, "Memory allocation failed!\n");
+        for (std::size_t cIndex = 0; cIndex < sNumFields; ++cIndex)
+            mColumns[cIndex] = mStorage + cOffsets[cIndex];
+        mCapacity = aCapacity;
+
+        // Calculate where index values will wrap-around to zero
+        static constexpr auto sMaxValue          = std::numeric_limits<int>::max();
+        auto                  cMaxNumWrapArounds = sMaxValue / mCapacity;
+        Assert(cMaxNumWrapArounds >= 2, "Not enough wrap-arounds!\n");
+        mIndexEnd = mCapacity * cMaxNumWrapArounds;
+    }
+
+    bool Is_Allocated() const { return (mStorage != nullptr); }
+
+    template <QueueAllocator AllocatorType>
+    void Free(AllocatorType& aAllocator) {
+        Assert(Is_Allocated(), "No memory to free!\n");
+        Assert(empty(), "Can't free until empty!\n");
+
+        Free_Storage(aAllocator, mStorage, mNumBytes, sColumnAlign);
+        mStorage  = nullptr;
+        mColumns  = {};
+        mNumBytes = 0;
+        mCapacity = 0;
+    }
+
+    bool Emplace(const FieldTypes&... aFields) {
+        // Load indices
+        // Push load relaxed: Only this thread can modify it
+        auto cUnwrappedPushIndex = mPushIndex.value.load(std::memory_order::relaxed);
+        // Pop load acquire: Column writes cannot be reordered above this
+        auto cUnwrappedPopIndex = mPopIndex.value.load(std::memory_order::acquire);
+
+        // Guard against the container being full
+        auto cIndexDelta = cUnwrappedPushIndex - cUnwrappedPopIndex;
+        if ((cIndexDelta == mCapacity) || (cIndexDelta == (mCapacity - mIndexEnd)))
+            return false;  // Full. The second check handled wrap-around
+
+        // Write one entry into every column
+        auto        cPushIndex = cUnwrappedPushIndex % mCapacity;
+        std::size_t cColumn    = 0;
+        (Write_Column(cColumn++, cPushIndex, &aFields, 1), ...);
+
+        // Advance push index
+        auto cNewPushIndex = Bump_Index(cUnwrappedPushIndex);
+        // Push store release: Column writes cannot be reordered below this
+        mPushIndex.value.store(cNewPushIndex, std::memory_order::release);
+
+        // Update the size
+        Increase_Size(1);
+        return true;
+    }
+
+    bool Pop(FieldTypes&... aFields) {
+        // Load indices
+        // Push load acquire: The pop cannot be reordered above this
+        auto cUnwrappedPushIndex = mPushIndex.value.load(std::memory_order::acquire);
+        // Pop load relaxed: Only this thread can modify it
+        auto cUnwrappedPopIndex = mPopIndex.value.load(std::memory_order::relaxed);
+
+        // Guard against the container being empty
+        if (cUnwrappedPopIndex == cUnwrappedPushIndex)
+            return false;  // The queue is empty
+
+        // Read one entry from every column
+        auto        cPopIndex = cUnwrappedPopIndex % mCapacity;
+        std::size_t cColumn   = 0;
+        (Read_Column(cColumn++, cPopIndex, &aFields, 1), ...);
+
+        // Advance pop index
+        auto cNewPopIndex = Bump_Index(cUnwrappedPopIndex);
+        // Pop store release: The pop cannot be reordered below this
+        mPopIndex.value.store(cNewPopIndex, std::memory_order::release);
+
+        // Update the size
+        Decrease_Size(1);
+        return true;
+    }
+
+    // Pushes the leading rows of the input columns (all must have the same length).
+    // Returns the number of rows pushed.
+    int Emplace_Multiple(std::span<const FieldTypes>... aColumns) {
+        const auto cSpanSize = static_cast<int>(std::get<0>(std::tie(aColumns...)).size());
+        Assert(((static_cast<int>(aColumns.size()) == cSpanSize) && ...),
+               "Column spans must have the same length!\n");
+
+        // Load indices
+        // Push load relaxed: Only this thread can modify it
+        auto cUnwrappedPushIndex = mPushIndex.value.load(std::memory_order::relaxed);
+        // Pop load acquire: Column writes cannot be reordered above this
+        auto cUnwrappedPopIndex = mPopIndex.value.load(std::memory_order::acquire);
+
+        // Can only push up to the pop index
+        auto cMaxPushIndex      = cUnwrappedPopIndex + mCapacity;
+        auto cMaxSlotsAvailable = cMaxPushIndex - cUnwrappedPushIndex;
+        cMaxSlotsAvailable -= (cMaxSlotsAvailable >= mIndexEnd) ? mIndexEnd : 0;
+        auto cNumToPush = std::min(cSpanSize, cMaxSlotsAvailable);
+        if (cNumToPush == 0)
+            return 0;  // The queue is full.
+
+        // Push every column (Write_Column handles the wrap-around)
+        auto        cPushIndex = cUnwrappedPushIndex % mCapacity;
+        std::size_t cColumn    = 0;
+        (Write_Column(cColumn++, cPushIndex, aColumns.data(), cNumToPush), ...);
+
+        // Advance push index
+        auto cNewPushIndex = Increase_Index(cUnwrappedPushIndex, cNumToPush);
+        // Push store release: Column writes cannot be reordered below this
+        mPushIndex.value.store(cNewPushIndex, std::memory_order::release);
+
+        // Update the size
+        Increase_Size(cNumToPush);
+        return cNumToPush;
+    }
+
+    // Pops as many rows as fit in the shortest output column. Returns the number of rows popped.
+    int Pop_Multiple(std::span<FieldTypes>... aColumns) {
+        // Load indices
+        // Push load acquire: The pop cannot be reordered above this
+        auto cUnwrappedPushIndex = mPushIndex.value.load(std::memory_order::acquire);
+        // Pop load relaxed: Only this thread can modify it
+        auto cUnwrappedPopIndex = mPopIndex.value.load(std::memory_order::relaxed);
+
+        // Can only pop up to the push index
+        auto cMaxSlotsAvailable = cUnwrappedPushIndex - cUnwrappedPopIndex;
+        cMaxSlotsAvailable += (cMaxSlotsAvailable < 0) ? mIndexEnd : 0;
+        auto cOutputSpaceAvailable = std::min({static_cast<int>(aColumns.size())...});
+        auto cNumToPop             = std::min(cOutputSpaceAvailable, cMaxSlotsAvailable);
+        if (cNumToPop == 0)
+            return 0;  // The queue is empty.
+
+        // Pop every column (Read_Column handles the wrap-around)
+        auto        cPopIndex = cUnwrappedPopIndex % mCapacity;
+        std::size_t cColumn   = 0;
+        (Read_Column(cColumn++, cPopIndex, aColumns.data(), cNumToPop), ...);
+
+        // Advance pop index
+        auto cNewPopIndex = Increase_Index(cUnwrappedPopIndex, cNumToPop);
+        // Pop store release: The pop cannot be reordered below this
+        mPopIndex.value.store(cNewPopIndex, std::memory_order::release);
+
+        // Update the size
+        Decrease_Size(cNumToPop);
+        return cNumToPop;
+    }
+
+    void Emplace_Await(const FieldTypes&... aFields)
+        requires(sPushAwait)
+    {
+        // Acquire: Need sync to see the latest queue indices
+        while (!Emplace(aFields...))
+            mSize.value.wait(mCapacity, std::memory_order::acquire);
+    }
+
+    void Emplace_Multiple_Await(std::span<const FieldTypes>... aColumns)
+        requires(sPushAwait)
+    {
+        while (true) {
+            auto cNumPushed = Emplace_Multiple(aColumns...);
+            ((aColumns = aColumns.subspan(cNumPushed)), ...);
+            if (std::get<0>(std::tie(aColumns...)).empty())
+                return;
+
+            // Acquire: Need sync to see the latest queue indices
+            mSize.value.wait(mCapacity, std::memory_order::acquire);
+        }
+    }
+
+    bool Pop_Await(FieldTypes&... aFields)
+        requires(sPopAwait)
+    {
+        while (true) {
+            if (Pop(aFields...))
+                return true;
+
+            // Comments are identical to Queue::Pop_Await()
+            mSize.value.wait(0, std::memory_order::acquire);
+            if (mSize.value.load(std::memory_order::relaxed) == sSizeMask)
+                return false;
+        }
+    }
+
+    int Pop_Multiple_Await(std::span<FieldTypes>... aColumns)
+        requires(sPopAwait)
+    {
+        // Else nothing fits, so it would spin: the size isn't 0 to wait on
+        Assert((!aColumns.empty() && ...), "Output column spans can't be empty!\n");
+        while (true) {
+            auto cNumPopped = Pop_Multiple(aColumns...);
+            if (cNumPopped != 0)
+                return cNumPopped;
+
+            // Comments are identical to Queue::Pop_Await()
+            mSize.value.wait(0, std::memory_order::acquire);
+            if (mSize.value.load(std::memory_order::relaxed) == sSizeMask)
+                return 0;
+        }
+    }
+
+    // Queue state
+    size_t size() const {
+        // Relaxed: Nothing to synchronize when reading this
+        auto cSize = mSize.value.load(std::memory_order::relaxed);
+        return cSize & (~sSizeMask);  // Clear the high bit!
+    }
+
+    bool empty() const { return size() == 0; }
+
+    int capacity() const { return mCapacity; }
+
+    // Wait control
+    void End_PopWaiting()
+        requires(sPopAwait)
+    {
+        // Comments are identical to Queue::End_PopWaiting()
+        auto cPriorSize = mSize.value.fetch_or(sSizeMask, std::memory_order::release);
+        if (cPriorSize == 0)
+            mSize.value.notify_all();
+    }
+
+    void Reset_PopWaiting()
+        requires(sPopAwait)
+    {
+        // Relaxed: Sync of other data is not needed: Queue state unchanged
+        mSize.value.fetch_and(~sSizeMask, std::memory_order::relaxed);
+    }
+
+  private:
+    // Helper methods
+    static std::size_t Round_Up(std::size_t aNumBytes) {
+        return ((aNumBytes + sColumnAlign - 1) / sColumnAlign) * sColumnAlign;
+    }
+
+    // Columns are trivially copyable, so memcpy both creates and reads the objects.
+    template <typename FieldType>
+    void Write_Column(std::size_t aColumn, int aRingIndex, const FieldType* aSource, int aCount) {
+        auto cRing              = mColumns[aColumn];
+        auto cDistanceBeyondEnd = (aRingIndex + aCount) - mCapacity;
+        if (cDistanceBeyondEnd <= 0) {
+            std::memcpy(cRing + aRingIndex * sizeof(FieldType), aSource,
+                        aCount * sizeof(FieldType));
+            return;
+        }
+
+        auto cInitialLength = aCount - cDistanceBeyondEnd;
+        std::memcpy(cRing + aRingIndex * sizeof(FieldType), aSource,
+                    cInitialLength * sizeof(FieldType));
+        std::memcpy(cRing, aSource + cInitialLength, cDistanceBeyondEnd * sizeof(FieldType));
+    }
+
+    template <typename FieldType>
+    void Read_Column(std::size_t aColumn, int aRingIndex, FieldType* aDestination, int aCount) {
+        auto cRing              = mColumns[aColumn];
+        auto cDistanceBeyondEnd = (aRingIndex + aCount) - mCapacity;
+        if (cDistanceBeyondEnd <= 0) {
+            std::memcpy(aDestination, cRing + aRingIndex * sizeof(FieldType),
+                        aCount * sizeof(FieldType));
+            return;
+        }
+
+        auto cInitialLength = aCount - cDistanceBeyondEnd;
+        std::memcpy(aDestination, cRing + aRingIndex * sizeof(FieldType),
+                    cInitialLength * sizeof(FieldType));
+        std::memcpy(aDestination + cInitialLength, cRing, cDistanceBeyondEnd * sizeof(FieldType));
+    }
+
+    int Bump_Index(int aIndex) const {
+        int cIncremented = aIndex + 1;
+        return (cIncremented < mIndexEnd) ? cIncremented : 0;
+    }
+
+    int Increase_Index(int aIndex, int aIncrease) const {
+        int cNewIndex = aIndex + aIncrease;
+        cNewIndex -= (cNewIndex >= mIndexEnd) ? mIndexEnd : 0;
+        return cNewIndex;
+    }
+
+    void Increase_Size(int aNumPushed) {
+        // Comments are identical to Queue::Increase_Size()
+        static constexpr auto sOrder =
+            sPopAwait ? std::memory_order::release : std::memory_order::relaxed;
+        [[maybe_unused]] auto cPriorSize = mSize.value.fetch_add(aNumPushed, sOrder);
+
+        if constexpr (sPopAwait) {
+            if (cPriorSize == 0)
+                mSize.value.notify_all();
+        }
+    }
+
+    void Decrease_Size(int aNumPopped) {
+        // Comments are identical to Queue::Decrease_Size()
+        static constexpr auto sOrder =
+            sPushAwait ? std::memory_order::release : std::memory_order::relaxed;
+        [[maybe_unused]] auto cPriorSize = mSize.value.fetch_sub(aNumPopped, sOrder);
+
+        if constexpr (sPushAwait) {
+            if ((cPriorSize & (~sSizeMask)) == mCapacity)
+                mSize.value.notify_all();
+        }
+    }
+
+    // OVER-ALIGNED MEMBERS
+    PaddedAtomicInt mPushIndex;
+    PaddedAtomicInt mPopIndex;
+    PaddedAtomicInt mSize;
+
+    // DEFAULT-ALIGNED MEMBERS
+    // Not over-aligned as neither these nor the column pointers change
+    std::byte*                         mStorage  = nullptr;  // Object Memory (all columns)
+    std::array<std::byte*, sNumFields> mColumns  = {};       // Start of each column ring
+    std::size_t                        mNumBytes = 0;        // Of the whole allocation
+    int                                mCapacity = 0;
+    int                                mIndexEnd = 0;  // at this, wrap indices around to zero
+};
+
+template <typename FieldList, WaitPolicy Waiting = WaitPolicy::NoWaits>
+using SPSC_SoA = SoAQueue<FieldList, Waiting>;
@@ -0,0 +1,499 @@
+#pragma once
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <new>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#include "common.hpp"
+
+// Inter-process SPSC queue living in a shared memory segment.
+// The segment starts with a placement-constructed SharedQueueHeader (padded indices, size and
+// geometry) followed by the object storage, which is located by offset so that every process can
+// map the segment at a different address. Waiting uses process-shared futexes, as the
+// std::atomic wait/notify implementation is allowed to use process-private ones.
+
+// Process-shared futex helpers
+static_assert(std::atomic<int>::is_always_lock_free && (sizeof(std::atomic<int>) == sizeof(int)),
+              "Futex words must be plain ints!");
+
+inline void Shared_Wait(std::atomic<int>& aWord, int aExpected) {
+    // Returns immediately if the value already differs, spurious wake-ups are fine for callers
+    syscall(SYS_futex, reinterpret_cast<int*>(&aWord), FUTEX_WAIT, aExpected, nullptr, nullptr, 0);
+}
+
+inline void Shared_Notify_All(std::atomic<int>& aWord) {
+    syscall(SYS_futex, reinterpret_cast<int*>(&aWord), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+struct SharedQueueHeader {
+    static constexpr std::uint32_t sMagic   = 0x53505343;  // "SPSC"
+    static constexpr std::uint32_t sVersion = 2;           // 2: 128-byte index padding on x86
+    static constexpr auto          sAlign   = hardware_destructive_interference_size;
+
+    SharedQueueHeader(int aCapacity, int aIndexEnd, std::uint32_t aElementSize,
+                      std::uint32_t aElementAlign, std::uint64_t aStorageOffset)
+        : mVersion(sVersion), mElementSize(aElementSize), mElementAlign(aElementAlign),
+          mCapacity(aCapacity), mIndexEnd(aIndexEnd), mStorageOffset(aStorageOffset) {}
+
+    // Written last by the creator (release), checked first by attachers (acquire)
+    std::atomic<std::uint32_t> mMagic{0};
+
+    // Geometry, immutable after creation
+    std::uint32_t mVersion;
+    std::uint32_t mElementSize;
+    std::uint32_t mElementAlign;
+    int           mCapacity;
+    int           mIndexEnd;       // at this, we need to wrap indices around to zero
+    std::uint64_t mStorageOffset;  // From the start of the header, not a pointer!
+
+    // OVER-ALIGNED MEMBERS
+    PaddedAtomicInt mPushIndex;
+    PaddedAtomicInt mPopIndex;
+    PaddedAtomicInt mSize;
+};
+
+template <typename DataType, WaitPolicy Waiting = WaitPolicy::NoWaits>
+class SharedSPSC {
+    static_assert(std::is_trivially_copyable_v<DataType>,
+                  "Shared memory queues can only hold trivially copyable types!");
+
+    // CONSTEXPR MEMBERS (needed for requires clauses)
+    static constexpr bool sPushAwait = Await_Pushes(Waiting);
+    static constexpr bool sPopAwait  = Await_Pops(Waiting);
+    static constexpr int  sSizeMask  = 0x80000000;  // ASSUMES 32 BIT int!
+    static constexpr auto sAlignment = std::max(SharedQueueHeader::sAlign, alignof(DataType));
+
+  public:
+    // Creation/Attachment
+    // Named segments (shm_open) can be attached by unrelated processes, and are unlinked when the
+    // creating handle is destroyed. Anonymous segments (memfd_create) are shared through Fd(),
+    // either inherited across fork() or passed over a Unix socket.
+
+    static SharedSPSC Create(const std::string& aName, int aCapacity) {
+        auto cFd = shm_open(aName.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (cFd < 0)
+            throw std::system_error(errno, std::generic_category(), "shm_open " + aName);
+
+        SharedSPSC cQueue;
+        cQueue.mFd   = cFd;
+        cQueue.mName = aName;
+        cQueue.Initialize(aCapacity);
+        return cQueue;
+    }
+
+    static SharedSPSC Create_Anonymous(int aCapacity) {
+        auto cFd = memfd_create("spsc-queue", MFD_CLOEXEC);
+        if (cFd < 0)
+            throw std::system_error(errno, std::generic_category(), "memfd_create");
+
+        SharedSPSC cQueue;
+        cQueue.mFd = cFd;
+        cQueue.Initialize(aCapacity);
+        return cQueue;
+    }
+
+    static SharedSPSC Attach(const std::string& aName) {
+        auto cFd = shm_open(aName.c_str(), O_RDWR, 0600);
+        if (cFd < 0)
+            throw std::system_error(errno, std::generic_category(), "shm_open " + aName);
+
+        SharedSPSC cQueue;
+        cQueue.mFd = cFd;
+        cQueue.Map_Existing();
+        return cQueue;
+    }
+
+    // Takes its own duplicate of aFd, the caller keeps ownership of aFd
+    static SharedSPSC Attach(int aFd) {
+        auto cFd = fcntl(aFd, F_DUPFD_CLOEXEC, 0);
+        if (cFd < 0)
+            throw std::system_error(errno, std::generic_category(), "fcntl F_DUPFD_CLOEXEC");
+
+        SharedSPSC cQueue;
+        cQueue.mFd = cFd;
+        cQueue.Map_Existing();
+        return cQueue;
+    }
+
+    // Constructor/Destructor
+    SharedSPSC() = default;
+    ~SharedSPSC() { Release(); }
+
+    SharedSPSC(SharedSPSC&& aOther) noexcept { Take(aOther); }
+    SharedSPSC& operator=(SharedSPSC&& aOther) noexcept {
+        if (this != &aOther) {
+            Release();
+            Take(aOther);
+        }
+        return *this;
+    }
+
+    SharedSPSC(const SharedSPSC&)            = delete;
+    SharedSPSC& operator=(const SharedSPSC&) = delete;
+
+    bool Is_Attached() const { return (mHeader != nullptr); }
+    int  Fd() const { return mFd; }
+
+    template <typename... ArgumentTypes>
+    bool Emplace(ArgumentTypes&&... aArguments) {
+        // Load indices
+        // Push load relaxed: Only this process can modify it
+        auto cUnwrappedPushIndex = mHeader->mPushIndex.value.load(std::memory_order::relaxed);
+        // Pop load acquire: Object creation cannot be reordered above this
+        auto cUnwrappedPopIndex = mHeader->mPopIndex.value.load(std::memory_order::acquire);
+
+        // Guard against the container being full
+        auto cIndexDelta = cUnwrappedPushIndex - cUnwrappedPopIndex;
+        if ((cIndexDelta == mCapacity) || (cIndexDelta == (mCapacity - mIndexEnd)))
+            return false;  // Full. The second check handled wrap-around
+
+        // Emplace the object
+        auto cPushIndex = cUnwrappedPushIndex % mCapacity;
+        auto cAddress   = mStorage + cPushIndex * sizeof(DataType);
+        new (cAddress) DataType(std::forward<ArgumentTypes>(aArguments)...);
+
+        // Advance push index
+        auto cNewPushIndex = Bump_Index(cUnwrappedPushIndex);
+        // Push store release: Object creation cannot be reordered below this
+        mHeader->mPushIndex.value.store(cNewPushIndex, std::memory_order::release);
+
+        // Update the size
+        Increase_Size(1);
+        return true;
+    }
+
+    bool Pop(DataType& aPopped) {
+        // Load indices
+        // Push load acquire: The pop cannot be reordered above this
+        auto cUnwrappedPushIndex = mHeader->mPushIndex.value.load(std::memory_order::acquire);
+        // Pop load relaxed: Only this process can modify it
+        auto cUnwrappedPopIndex = mHeader->mPopIndex.value.load(std::memory_order::relaxed);
+
+        // Guard against the container being empty
+        if (cUnwrappedPopIndex == cUnwrappedPushIndex)
+            return false;  // The queue is empty
+
+        // Pop data (trivially copyable: no destructor to run)
+        auto cPopIndex = cUnwrappedPopIndex % mCapacity;
+        std::memcpy(&aPopped, mStorage + cPopIndex * sizeof(DataType), sizeof(DataType));
+
+        // Advance pop index
+        auto cNewPopIndex = Bump_Index(cUnwrappedPopIndex);
+        // Pop store release: The pop cannot be reordered below this
+        mHeader->mPopIndex.value.store(cNewPopIndex, std::memory_order::release);
+
+        // Update the size
+        Decrease_Size(1);
+        return true;
+    }
+
+    std::span<const DataType> Emplace_Multiple(std::span<const DataType> aSpan) {
+        // Load indices
+        // Push load relaxed: Only this process can modify it
+        auto cUnwrappedPushIndex = mHeader->mPushIndex.value.load(std::memory_order::relaxed);
+        // Pop load acquire: Object creation cannot be reordered above this
+        auto cUnwrappedPopIndex = mHeader->mPopIndex.value.load(std::memory_order::acquire);
+
+        // Can only push up to the pop index
+        auto cMaxPushIndex      = cUnwrappedPopIndex + mCapacity;
+        auto cMaxSlotsAvailable = cMaxPushIndex - cUnwrappedPushIndex;
+        cMaxSlotsAvailable -= (cMaxSlotsAvailable >= mIndexEnd) ? mIndexEnd : 0;
+        const auto cSpanSize  = static_cast<int>(aSpan.size());
+        auto       cNumToPush = std::min(cSpanSize, cMaxSlotsAvailable);
+        if (cNumToPush == 0)
+            return aSpan;  // The queue is full.
+
+        // Push data, in up to two chunks if wrapping around
+        auto cPushIndex         = cUnwrappedPushIndex % mCapacity;
+        auto cDistanceBeyondEnd = (cPushIndex + cNumToPush) - mCapacity;
+        auto cInitialLength     = cNumToPush - std::max(cDistanceBeyondEnd, 0);
+        std::memcpy(mStorage + cPushIndex * sizeof(DataType), aSpan.data(),
+                    cInitialLength * sizeof(DataType));
+        if (cDistanceBeyondEnd > 0) {
+            std::memcpy(mStorage, aSpan.data() + cInitialLength,
+                        cDistanceBeyondEnd * sizeof(DataType));
+        }
+
+        // Advance push index
+        auto cNewPushIndex = Increase_Index(cUnwrappedPushIndex, cNumToPush);
+        // Push store release: Object creation cannot be reordered below this
+        mHeader->mPushIndex.value.store(cNewPushIndex, std::memory_order::release);
+
+        // Update the size
+        Increase_Size(cNumToPush);
+
+        // Return unfinished entries
+        return aSpan.subspan(cNumToPush);
+    }
+
+    template <typename ContainerType>
+    void Pop_Multiple(ContainerType& aPopped) {
+        // Load indices
+        // Push load acquire: The pop cannot be reordered above this
+        auto cUnwrappedPushIndex = mHeader->mPushIndex.value.load(std::memory_order::acquire);
+        // Pop load relaxed: Only this process can modify it
+        auto cUnwrappedPopIndex = mHeader->mPopIndex.value.load(std::memory_order::relaxed);
+
+        // Can only pop up to the push index
+        auto cMaxSlotsAvailable = cUnwrappedPushIndex - cUnwrappedPopIndex;
+        cMaxSlotsAvailable += (cMaxSlotsAvailable < 0) ? mIndexEnd : 0;
+        auto cOutputSpaceAvailable = static_cast<int>(aPopped.capacity() - aPopped.size());
+        auto cNumToPop             = std::min(cOutputSpaceAvailable, cMaxSlotsAvailable);
+        if (cNumToPop == 0)
+            return;  // The queue is empty.
+
+        // Pop data, in up to two chunks if wrapping around
+        auto cPopIndex          = cUnwrappedPopIndex % mCapacity;
+        auto cPopFromData       = std::launder(reinterpret_cast<DataType*>(mStorage)) + cPopIndex;
+        auto cDistanceBeyondEnd = (cPopIndex + cNumToPop) - mCapacity;
+        if (cDistanceBeyondEnd <= 0)
+            aPopped.insert(std::end(aPopped), cPopFromData, cPopFromData + cNumToPop);
+        else {
+            auto cInitialLength = cNumToPop - cDistanceBeyondEnd;
+            aPopped.insert(std::end(aPopped), cPopFromData, cPopFromData + cInitialLength);
+
+            cPopFromData = std::launder(reinterpret_cast<DataType*>(mStorage));
+            aPopped.insert(std::end(aPopped), cPopFromData, cPopFromData + cDistanceBeyondEnd);
+        }
+
+        // Advance pop index
+        auto cNewPopIndex = Increase_Index(cUnwrappedPopIndex, cNumToPop);
+        // Pop store release: The pop cannot be reordered below this
+        mHeader->mPopIndex.value.store(cNewPopIndex, std::memory_order::release);
+
+        // Update the size
+        Decrease_Size(cNumToPop);
+    }
+
+    template <typename... ArgumentTypes>
+    void Emplace_Await(ArgumentTypes&&... aArguments)
+        requires(sPushAwait)
+    {
+        while (!Emplace(std::forward<ArgumentTypes>(aArguments)...))
+            Shared_Wait(mHeader->mSize.value, mCapacity);
+    }
+
+    void Emplace_Multiple_Await(std::span<const DataType> aSpan)
+        requires(sPushAwait)
+    {
+        while (true) {
+            aSpan = Emplace_Multiple(aSpan);
+            if (aSpan.empty())
+                return;
+
+            Shared_Wait(mHeader->mSize.value, mCapacity);
+        }
+    }
+
+    bool Pop_Await(DataType& aPopped)
+        requires(sPopAwait)
+    {
+        while (true) {
+            if (Pop(aPopped))
+                return true;
+
+            // The queue was empty, wait until the producer pushes or we're ending
+            Shared_Wait(mHeader->mSize.value, 0);
+
+            // If mSize is sSizeMask then nothing will push, and none left to pop.
+            if (mHeader->mSize.value.load(std::memory_order::acquire) == sSizeMask)
+                return false;
+        }
+    }
+
+    template <typename ContainerType>
+    void Pop_Multiple_Await(ContainerType& aPopped)
+        requires(sPopAwait)
+    {
+        while (true) {
+            Pop_Multiple(aPopped);
+            if (!aPopped.empty())
+                return;
+
+            // Comments are identical to Pop_Await()
+            Shared_Wait(mHeader->mSize.value, 0);
+            if (mHeader->mSize.value.load(std::memory_order::acquire) == sSizeMask)
+                return;
+        }
+    }
+
+    // Queue state
+    size_t size() const {
+        // Relaxed: Nothing to synchronize when reading this
+        auto cSize = mHeader->mSize.value.load(std::memory_order::relaxed);
+        return cSize & (~sSizeMask);  // Clear the high bit!
+    }
+
+    bool empty() const { return size() == 0; }
+
+    int capacity() const { return mCapacity; }
+
+    // Wait control
+    void End_PopWaiting()
+        requires(sPopAwait)
+    {
+        // Comments are identical to Queue::End_PopWaiting()
+        auto cPriorSize = mHeader->mSize.value.fetch_or(sSizeMask, std::memory_order::release);
+        if (cPriorSize == 0)
+            Shared_Notify_All(mHeader->mSize.value);
+    }
+
+    void Reset_PopWaiting()
+        requires(sPopAwait)
+    {
+        // Relaxed: Sync of other data is not needed: Queue state unchanged
+        mHeader->mSize.value.fetch_and(~sSizeMask, std::memory_order::relaxed);
+    }
+
+  private:
+    // Segment management
+    static std::size_t Storage_Offset() {
+        return ((sizeof(SharedQueueHeader) + sAlignment - 1) / sAlignment) * sAlignment;
+    }
+
+    void Initialize(int aCapacity) {
+        Assert(aCapacity > 0, "Invalid capacity {}!\n", aCapacity);
+
+        // Calculate where index values will wrap-around to zero
+        static constexpr auto sMaxValue          = std::numeric_limits<int>::max();
+        auto                  cMaxNumWrapArounds = sMaxValue / aCapacity;
+        Assert(cMaxNumWrapArounds >= 2, "Not enough wrap-arounds!\n");
+
+        // Size the segment (new pages are zero-filled) and map it
+        mMappedBytes = Storage_Offset() + aCapacity * sizeof(DataType);
+        if (ftruncate(mFd, static_cast<off_t>(mMappedBytes)) != 0)
+            throw std::system_error(errno, std::generic_category(), "ftruncate");
+        Map();
+
+        // Placement-construct the header, then publish it
+        mHeader = new (mSegment) SharedQueueHeader(aCapacity, aCapacity * cMaxNumWrapArounds,
+                                                   sizeof(DataType), alignof(DataType),
+                                                   Storage_Offset());
+        mHeader->mMagic.store(SharedQueueHeader::sMagic, std::memory_order::release);
+        Cache_Geometry();
+    }
+
+    void Map_Existing() {
+        struct stat cStat;
+        if (fstat(mFd, &cStat) != 0)
+            throw std::system_error(errno, std::generic_category(), "fstat");
+        mMappedBytes = static_cast<std::size_t>(cStat.st_size);
+        if (mMappedBytes < Storage_Offset())
+            throw std::runtime_error("Shared queue segment is too small!");
+        Map();
+
+        // Validate the header before trusting its geometry
+        mHeader = std::launder(reinterpret_cast<SharedQueueHeader*>(mSegment));
+        if (mHeader->mMagic.load(std::memory_order::acquire) != SharedQueueHeader::sMagic)
+            throw std::runtime_error("Shared queue segment is not initialized!");
+        if ((mHeader->mVersion != SharedQueueHeader::sVersion) ||
+            (mHeader->mElementSize != sizeof(DataType)) ||
+            (mHeader->mElementAlign != alignof(DataType)))
+            throw std::runtime_error("Shared queue segment holds a different data type!");
+        if (mHeader->mStorageOffset + mHeader->mCapacity * sizeof(DataType) > mMappedBytes)
+            throw std::runtime_error("Shared queue segment is truncated!");
+        Cache_Geometry();
+    }
+
+    void Map() {
+        auto cAddress = mmap(nullptr, mMappedBytes, PROT_READ | PROT_WRITE, MAP_SHARED, mFd, 0);
+        if (cAddress == MAP_FAILED)
+            throw std::system_error(errno, std::generic_category(), "mmap");
+        mSegment = static_cast<std::byte*>(cAddress);
+    }
+
+    // The geometry never changes, so keep process-local copies next to the storage pointer
+    void Cache_Geometry() {
+        mStorage  = mSegment + mHeader->mStorageOffset;
+        mCapacity = mHeader->mCapacity;
+        mIndexEnd = mHeader->mIndexEnd;
+    }
+
+    void Release() {
+        if (mSegment != nullptr)
+            munmap(mSegment, mMappedBytes);
+        if (mFd >= 0)
+            close(mFd);
+        if (!mName.empty())
+            shm_unlink(mName.c_str());
+        mHeader  = nullptr;
+        mSegment = nullptr;
+        mStorage = nullptr;
+        mFd      = -1;
+        mName.clear();
+    }
+
+    void Take(SharedSPSC& aOther) {
+        mHeader      = std::exchange(aOther.mHeader, nullptr);
+        mSegment     = std::exchange(aOther.mSegment, nullptr);
+        mStorage     = std::exchange(aOther.mStorage, nullptr);
+        mMappedBytes = std::exchange(aOther.mMappedBytes, 0);
+        mFd          = std::exchange(aOther.mFd, -1);
+        mName        = std::exchange(aOther.mName, std::string());
+        mCapacity    = aOther.mCapacity;
+        mIndexEnd    = aOther.mIndexEnd;
+    }
+
+    // Helper methods
+    int Bump_Index(int aIndex) const {
+        int cIncremented = aIndex + 1;
+        return (cIncremented < mIndexEnd) ? cIncremented : 0;
+    }
+
+    int Increase_Index(int aIndex, int aIncrease) const {
+        int cNewIndex = aIndex + aIncrease;
+        cNewIndex -= (cNewIndex >= mIndexEnd) ? mIndexEnd : 0;
+        return cNewIndex;
+    }
+
+    void Increase_Size(int aNumPushed) {
+        // Comments are identical to Queue::Increase_Size()
+        static constexpr auto sOrder =
+            sPopAwait ? std::memory_order::release : std::memory_order::relaxed;
+        [[maybe_unused]] auto cPriorSize = mHeader->mSize.value.fetch_add(aNumPushed, sOrder);
+
+        if constexpr (sPopAwait) {
+            if (cPriorSize == 0)
+                Shared_Notify_All(mHeader->mSize.value);
+        }
+    }
+
+    void Decrease_Size(int aNumPopped) {
+        // Comments are identical to Queue::Decrease_Size()
+        static constexpr auto sOrder =
+            sPushAwait ? std::memory_order::release : std::memory_order::relaxed;
+        [[maybe_unused]] auto cPriorSize = mHeader->mSize.value.fetch_sub(aNumPopped, sOrder);
+
+        if constexpr (sPushAwait) {
+            if ((cPriorSize & (~sSizeMask)) == mCapacity)
+                Shared_Notify_All(mHeader->mSize.value);
+        }
+    }
+
+    // Shared state lives in the segment, everything else here is process-local
+    SharedQueueHeader* mHeader      = nullptr;
+    std::byte*         mSegment     = nullptr;  // Start of this process' mapping
+    std::byte*         mStorage     = nullptr;  // mSegment + mHeader->mStorageOffset
+    std::size_t        mMappedBytes = 0;
+    int                mFd          = -1;
+    int                mCapacity    = 0;
+    int                mIndexEnd    = 0;
+    std::string        mName;  // Set only for the creator of a named segment: unlinks it
+};
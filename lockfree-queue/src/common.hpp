@@ -12,17 +12,39 @@ constexpr bool Await_Pops(WaitPolicy aWaiting) {
     return (aWaiting == WaitPolicy::PopAwait) || (aWaiting == WaitPolicy::BothAwait);
 }
 
+// Optional instrumentation: Counters keeps per-side operation counts, Latency traces the time
+// from push to pop of each item. None compiles it all out.
+enum class StatsPolicy { None = 0, Counters, Latency, All };
+
+constexpr bool Track_Counters(StatsPolicy aStats) {
+    return (aStats == StatsPolicy::Counters) || (aStats == StatsPolicy::All);
+}
+
+constexpr bool Track_Latency(StatsPolicy aStats) {
+    return (aStats == StatsPolicy::Latency) || (aStats == StatsPolicy::All);
+}
+
 // CLASS DECLARATION
-template <typename DataType, ThreadsPolicy Threading, WaitPolicy Waiting = WaitPolicy::NoWaits>
+template <typename DataType, ThreadsPolicy Threading, WaitPolicy Waiting = WaitPolicy::NoWaits,
+          StatsPolicy Stats = StatsPolicy::None>
 class Queue;
 
+// Structure-of-arrays SPSC ring: FieldList is a std::tuple of the column types
+template <typename FieldList, WaitPolicy Waiting = WaitPolicy::NoWaits>
+class SoAQueue;
+
 #pragma once
+#include <atomic>
+#include <concepts>
+#include <cstddef>
 #include <cstdlib>
 #include <iostream>
 #include <memory>
 #include <span>
 #include <sstream>
 
+#include "Topology.hpp"
+
 // Simple Assert function
 inline void Assert(bool condition, const std::string& message) {
     if (!condition) {
@@ -47,10 +69,48 @@ inline void Assert(bool condition, const std::string& message, const T& value) {
 template <typename T>
 using Span = std::span<T>;
 
-// Fallback for hardware_destructive_interference_size if not available
-#if __cpp_lib_hardware_interference_size >= 201603
-constexpr std::size_t hardware_destructive_interference_size =
-    std::hardware_destructive_interference_size;
-#else
-constexpr std::size_t hardware_destructive_interference_size = 64;  // Common cache line size
-#endif
+// Padding that keeps data written by different threads on different cache lines (128 bytes on
+// x86, for the adjacent-line prefetcher: see hw-utils/Topology.hpp). Fixed at compile time, as it
+// shapes the shared memory and journal file layouts.
+constexpr std::size_t hardware_destructive_interference_size = hw_utils::sFalseSharingPadding;
+
+// Default queue capacity: as many items as fit in half the L2 cache, so the ring stays cache
+// resident next to what the two threads do with the items. A power of two.
+inline int Default_Capacity(std::size_t aItemBytes) {
+    return hw_utils::L2_Resident_Count(aItemBytes, 0.5);
+}
+
+// An atomic index or size alone on its cache line(s): writes to it don't invalidate its neighbours
+struct alignas(hardware_destructive_interference_size) PaddedAtomicInt {
+    std::atomic<int> value{0};
+};
+
+// ALLOCATOR CONTRACT
+// Queue storage comes from Allocate(size, alignment), and is returned with either Free(ptr) or,
+// for allocators that need it (e.g. std::pmr resources), the sized Free(ptr, size, alignment).
+template <typename AllocatorType>
+concept SizedFreeAllocator = requires(AllocatorType& aAllocator, std::byte* aStorage,
+                                      std::size_t aSize, std::size_t aAlign) {
+    aAllocator.Free(aStorage, aSize, aAlign);
+};
+
+template <typename AllocatorType>
+concept UnsizedFreeAllocator = requires(AllocatorType& aAllocator, std::byte* aStorage) {
+    aAllocator.Free(aStorage);
+};
+
+template <typename AllocatorType>
+concept QueueAllocator =
+    requires(AllocatorType& aAllocator, std::size_t aSize, std::size_t aAlign) {
+        { aAllocator.Allocate(aSize, aAlign) } -> std::same_as<std::byte*>;
+    } && (SizedFreeAllocator<AllocatorType> || UnsizedFreeAllocator<AllocatorType>);
+
+// Returns queue storage through whichever Free() the allocator provides
+template <QueueAllocator AllocatorType>
+void Free_Storage(AllocatorType& aAllocator, std::byte* aStorage, std::size_t aSize,
+                  std::size_t aAlign) {
+    if constexpr (SizedFreeAllocator<AllocatorType>)
+        aAllocator.Free(aStorage, aSize, aAlign);
+    else
+        aAllocator.Free(aStorage);
+}
@@ -0,0 +1,185 @@
+#include <gtest/gtest.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "JournalSPSC.hpp"
+
+struct Order {
+    long   id;
+    double quantity;
+};
+
+// Test fixture for journaled queue tests
+class JournalSPSCTest : public ::testing::Test {
+  protected:
+    void SetUp() override {
+        path_ = ::testing::TempDir() + "journal_test_" + std::to_string(getpid()) + ".jrnl";
+        std::remove(path_.c_str());
+    }
+
+    void TearDown() override { std::remove(path_.c_str()); }
+
+    std::string path_;
+};
+
+TEST_F(JournalSPSCTest, CreateAndReopen) {
+    {
+        auto journal = JournalSPSC<Order>::Open(path_, 8);
+        EXPECT_TRUE(journal.Is_Open());
+        EXPECT_EQ(journal.Generation(), 1u);
+        EXPECT_EQ(journal.capacity(), 8);
+        EXPECT_TRUE(journal.Emplace(Order{1, 10.0}));
+        EXPECT_TRUE(journal.Emplace(Order{2, 20.0}));
+    }
+
+    // Reopening keeps the original capacity and the published entries
+    auto journal = JournalSPSC<Order>::Open(path_, 100);
+    EXPECT_EQ(journal.Generation(), 2u);
+    EXPECT_EQ(journal.capacity(), 8);
+    EXPECT_EQ(journal.size(), static_cast<size_t>(2));
+
+    Order order;
+    EXPECT_TRUE(journal.Pop(order));
+    EXPECT_EQ(order.id, 1);
+    EXPECT_TRUE(journal.Pop(order));
+    EXPECT_EQ(order.id, 2);
+    EXPECT_FALSE(journal.Pop(order));
+}
+
+TEST_F(JournalSPSCTest, UncommittedEntriesAreReplayed) {
+    {
+        auto journal = JournalSPSC<Order>::Open(path_, 16);
+        for (long i = 0; i < 10; ++i)
+            EXPECT_TRUE(journal.Emplace(Order{i, 1.0}));
+
+        Order order;
+        for (int i = 0; i < 4; ++i)
+            EXPECT_TRUE(journal.Pop(order));
+        journal.Commit();
+
+        // Read but never committed: must be replayed
+        EXPECT_TRUE(journal.Pop(order));
+        EXPECT_TRUE(journal.Pop(order));
+        EXPECT_EQ(journal.size(), static_cast<size_t>(6));
+    }
+
+    auto  journal = JournalSPSC<Order>::Open(path_, 16);
+    Order order;
+    for (long i = 4; i < 10; ++i) {
+        EXPECT_TRUE(journal.Pop(order));
+        EXPECT_EQ(order.id, i);
+    }
+    EXPECT_FALSE(journal.Pop(order));
+}
+
+TEST_F(JournalSPSCTest, RecoversFromConsumerCrash) {
+    constexpr long NUM_ITEMS = 1000;
+    {
+        auto journal = JournalSPSC<Order>::Open(path_, 2000);
+        for (long i = 0; i < NUM_ITEMS; ++i)
+            EXPECT_TRUE(journal.Emplace(Order{i, 0.5}));
+    }
+
+    // The consumer commits every 100 entries, then dies mid-batch without cleaning up
+    auto pid = fork();
+    if (pid == 0) {
+        auto  journal = JournalSPSC<Order>::Open(path_, 2000);
+        Order order;
+        for (long i = 0; i < 650; ++i) {
+            journal.Pop(order);
+            if ((i + 1) % 100 == 0)
+                journal.Commit();
+        }
+        std::abort();
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    EXPECT_TRUE(WIFSIGNALED(status));
+
+    // Replay resumes at the last commit
+    auto journal = JournalSPSC<Order>::Open(path_, 2000);
+    EXPECT_EQ(journal.Generation(), 3u);
+    EXPECT_EQ(journal.size(), static_cast<size_t>(NUM_ITEMS - 600));
+
+    std::vector<Order> orders;
+    orders.reserve(NUM_ITEMS);
+    journal.Pop_Multiple(orders);
+    ASSERT_EQ(orders.size(), static_cast<size_t>(NUM_ITEMS - 600));
+    EXPECT_EQ(orders.front().id, 600);
+    EXPECT_EQ(orders.back().id, NUM_ITEMS - 1);
+}
+
+TEST_F(JournalSPSCTest, SlotsAreReusedOnlyAfterCommit) {
+    auto journal = JournalSPSC<int>::Open(path_, 4);
+
+    std::vector<int> input = {1, 2, 3, 4, 5};
+    auto             rest  = journal.Emplace_Multiple(input);
+    EXPECT_EQ(rest.size(), static_cast<size_t>(1));
+
+    // Reading doesn't free any space
+    int value;
+    EXPECT_TRUE(journal.Pop(value));
+    EXPECT_FALSE(journal.Emplace(6));
+
+    // Committing does
+    journal.Commit();
+    EXPECT_TRUE(journal.Emplace_Multiple(rest).empty());
+    EXPECT_FALSE(journal.Emplace(6));
+}
+
+TEST_F(JournalSPSCTest, DurabilityModesWrapAround) {
+    for (auto durability : {Durability::Kernel, Durability::Batched, Durability::Immediate}) {
+        std::remove(path_.c_str());
+        {
+            auto journal = JournalSPSC<int>::Open(path_, 7, durability, 3);
+
+            std::vector<int> input = {1, 2, 3, 4, 5};
+            std::vector<int> output;
+            output.reserve(5);
+            for (int cycle = 0; cycle < 4; ++cycle) {
+                EXPECT_TRUE(journal.Emplace_Multiple(input).empty());
+                journal.Pop_Multiple(output);
+                EXPECT_EQ(output, input);
+                output.clear();
+                journal.Commit();
+            }
+            EXPECT_TRUE(journal.Emplace(42));
+        }
+
+        auto journal = JournalSPSC<int>::Open(path_, 7, durability);
+        int  value   = 0;
+        EXPECT_TRUE(journal.Pop(value));
+        EXPECT_EQ(value, 42);
+    }
+}
+
+TEST_F(JournalSPSCTest, RejectsDifferentDataType) {
+    { auto journal = JournalSPSC<Order>::Open(path_, 8); }
+    EXPECT_THROW(JournalSPSC<int>::Open(path_, 8), std::runtime_error);
+}
+
+TEST_F(JournalSPSCTest, ReinitializesAfterCrashDuringCreation) {
+    // A crash between sizing the file and storing the magic leaves it zero-filled
+    {
+        auto file = std::fopen(path_.c_str(), "wb");
+        ASSERT_NE(file, nullptr);
+        std::vector<char> zeros(static_cast<size_t>(sysconf(_SC_PAGESIZE)) + 8 * sizeof(Order));
+        std::fwrite(zeros.data(), 1, zeros.size(), file);
+        std::fclose(file);
+    }
+
+    auto journal = JournalSPSC<Order>::Open(path_, 16);
+    EXPECT_EQ(journal.Generation(), 1u);
+    EXPECT_EQ(journal.capacity(), 16);
+    EXPECT_TRUE(journal.empty());
+    EXPECT_TRUE(journal.Emplace(Order{1, 10.0}));
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
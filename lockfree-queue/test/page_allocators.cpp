@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+#include <linux/mempolicy.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "PageAllocators.hpp"
+#include "SPSC.hpp"
+
+// Pushes and pops enough items to wrap around a queue allocated from aAllocator
+template <typename AllocatorType>
+void Round_Trip(AllocatorType& aAllocator, int aCapacity) {
+    SPSC<std::uint64_t, WaitPolicy::NoWaits> queue;
+    queue.Allocate(aAllocator, aCapacity);
+    EXPECT_EQ(aAllocator.allocated_count(), static_cast<size_t>(1));
+
+    std::vector<std::uint64_t> input(aCapacity / 2 + 1);
+    std::vector<std::uint64_t> output;
+    output.reserve(input.size());
+    for (std::uint64_t cycle = 0; cycle < 4; ++cycle) {
+        for (size_t i = 0; i < input.size(); ++i)
+            input[i] = cycle * input.size() + i;
+        EXPECT_TRUE(queue.Emplace_Multiple(std::span<std::uint64_t>(input)).empty());
+        queue.Pop_Multiple(output);
+        EXPECT_EQ(output, input);
+        output.clear();
+    }
+
+    queue.Free(aAllocator);
+    EXPECT_EQ(aAllocator.allocated_count(), static_cast<size_t>(0));
+}
+
+TEST(HugePageAllocatorTest, TransparentHugePages) {
+    HugePageAllocator allocator;
+
+    // Allocations are rounded up to, and aligned on, huge pages
+    auto ptr = allocator.Allocate(3 * 1024 * 1024, 64);
+    ASSERT_NE(ptr, nullptr);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(ptr) % HugePageAllocator::sHugePageSize, 0u);
+    ptr[4 * 1024 * 1024 - 1] = std::byte{1};  // Whole rounded-up range is usable
+    allocator.Free(ptr);
+    EXPECT_EQ(allocator.allocated_count(), static_cast<size_t>(0));
+
+    Round_Trip(allocator, 1 << 20);
+}
+
+TEST(HugePageAllocatorTest, ExplicitHugePagesFallBack) {
+    HugePageAllocator allocator(HugePages::Explicit);
+
+    // Works whether or not the hugetlbfs pool is configured on this machine
+    auto ptr = allocator.Allocate(1024, 64);
+    ASSERT_NE(ptr, nullptr);
+    EXPECT_LE(allocator.fallback_count(), static_cast<size_t>(1));
+    allocator.Free(ptr);
+
+    Round_Trip(allocator, 1000);
+}
+
+TEST(NumaAllocatorTest, BindsPagesToNode) {
+    EXPECT_GE(NumaAllocator::Num_Nodes(), 1);
+    if (!NumaAllocator::Is_Node_Online(0))
+        GTEST_SKIP() << "No NUMA node information in sysfs";
+
+    NumaAllocator allocator(0);
+    auto          ptr = allocator.Allocate(1 << 20, 64);
+    ASSERT_NE(ptr, nullptr);
+
+    // Prefaulted pages already live on node 0
+    int node = -1;
+    ASSERT_EQ(syscall(SYS_get_mempolicy, &node, nullptr, 0, ptr, MPOL_F_NODE | MPOL_F_ADDR), 0);
+    EXPECT_EQ(node, 0);
+    allocator.Free(ptr);
+
+    Round_Trip(allocator, 1 << 16);
+}
+
+TEST(NumaAllocatorTest, RejectsUnknownNode) {
+    EXPECT_THROW(NumaAllocator(-1), std::invalid_argument);
+    EXPECT_THROW(NumaAllocator(100000), std::invalid_argument);
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
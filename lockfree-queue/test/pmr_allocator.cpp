@@ -0,0 +1,156 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstdint>
+#include <memory_resource>
+#include <tuple>
+#include <vector>
+
+#include "PageAllocators.hpp"
+#include "PmrAllocator.hpp"
+#include "SPSC.hpp"
+#include "SPSC_SoA.hpp"
+#include "test_allocator.hpp"
+
+// The contract accepts both Free() flavours, and rejects anything else
+struct NoFreeAllocator {
+    std::byte* Allocate(std::size_t, std::size_t) { return nullptr; }
+};
+
+struct WrongReturnAllocator {
+    void* Allocate(std::size_t, std::size_t) { return nullptr; }
+    void  Free(void*) {}
+};
+
+static_assert(QueueAllocator<TestAllocator>);
+static_assert(QueueAllocator<PmrAllocator>);
+static_assert(QueueAllocator<HugePageAllocator>);
+static_assert(SizedFreeAllocator<PmrAllocator>);
+static_assert(!SizedFreeAllocator<TestAllocator>);
+static_assert(!QueueAllocator<NoFreeAllocator>);
+static_assert(!QueueAllocator<WrongReturnAllocator>);
+static_assert(!QueueAllocator<int>);
+
+// Records every request, forwarding to an upstream resource
+class CountingResource : public std::pmr::memory_resource {
+  public:
+    struct Request {
+        void*       pointer;
+        std::size_t size;
+        std::size_t alignment;
+    };
+
+    std::vector<Request> allocations;
+    std::vector<Request> deallocations;
+
+  private:
+    void* do_allocate(std::size_t aSize, std::size_t aAlignment) override {
+        auto cPointer = std::pmr::new_delete_resource()->allocate(aSize, aAlignment);
+        allocations.push_back({cPointer, aSize, aAlignment});
+        return cPointer;
+    }
+
+    void do_deallocate(void* aPointer, std::size_t aSize, std::size_t aAlignment) override {
+        deallocations.push_back({aPointer, aSize, aAlignment});
+        std::pmr::new_delete_resource()->deallocate(aPointer, aSize, aAlignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& aOther) const noexcept override {
+        return this == &aOther;
+    }
+};
+
+// Pushes and pops enough items to wrap around the queue a few times
+void Round_Trip(SPSC<std::uint64_t, WaitPolicy::NoWaits>& aQueue, int aCapacity) {
+    std::vector<std::uint64_t> input(aCapacity / 2 + 1);
+    std::vector<std::uint64_t> output;
+    output.reserve(input.size());
+    for (std::uint64_t cycle = 0; cycle < 4; ++cycle) {
+        for (size_t i = 0; i < input.size(); ++i)
+            input[i] = cycle * input.size() + i;
+        EXPECT_TRUE(aQueue.Emplace_Multiple(std::span<std::uint64_t>(input)).empty());
+        aQueue.Pop_Multiple(output);
+        EXPECT_EQ(output, input);
+        output.clear();
+    }
+}
+
+TEST(PmrAllocatorTest, SizedFreeMatchesAllocate) {
+    CountingResource resource;
+    PmrAllocator     allocator(&resource);
+    EXPECT_EQ(allocator.resource(), &resource);
+
+    SPSC<std::uint64_t, WaitPolicy::NoWaits> queue;
+    queue.Allocate(allocator, 100);
+    Round_Trip(queue, 100);
+    queue.Free(allocator);
+
+    ASSERT_EQ(resource.allocations.size(), static_cast<size_t>(1));
+    ASSERT_EQ(resource.deallocations.size(), static_cast<size_t>(1));
+    EXPECT_EQ(resource.deallocations[0].pointer, resource.allocations[0].pointer);
+    EXPECT_EQ(resource.deallocations[0].size, resource.allocations[0].size);
+    EXPECT_EQ(resource.deallocations[0].alignment, resource.allocations[0].alignment);
+    EXPECT_GE(resource.allocations[0].size, 100 * sizeof(std::uint64_t));
+}
+
+TEST(PmrAllocatorTest, SoAQueueSizedFree) {
+    CountingResource resource;
+    PmrAllocator     allocator(&resource);
+
+    SPSC_SoA<std::tuple<int, double, char>> queue;
+    queue.Allocate(allocator, 50);
+    EXPECT_TRUE(queue.Emplace(1, 2.0, 'c'));
+    int    a;
+    double b;
+    char   c;
+    EXPECT_TRUE(queue.Pop(a, b, c));
+    queue.Free(allocator);
+
+    ASSERT_EQ(resource.deallocations.size(), static_cast<size_t>(1));
+    EXPECT_EQ(resource.deallocations[0].size, resource.allocations[0].size);
+    EXPECT_EQ(resource.deallocations[0].alignment, resource.allocations[0].alignment);
+}
+
+TEST(PmrAllocatorTest, MonotonicStartupBuffer) {
+    // All rings are carved out of one buffer reserved at startup; nothing reaches the heap
+    alignas(64) static std::array<std::byte, 64 * 1024> buffer;
+    std::pmr::monotonic_buffer_resource resource(buffer.data(), buffer.size(),
+                                                 std::pmr::null_memory_resource());
+    PmrAllocator                        allocator(&resource);
+
+    std::array<SPSC<std::uint64_t, WaitPolicy::NoWaits>, 4> queues;
+    for (auto& queue : queues) {
+        queue.Allocate(allocator, 1000);
+        Round_Trip(queue, 1000);
+    }
+    for (auto& queue : queues)
+        queue.Free(allocator);
+
+    // The buffer is exhausted: the null upstream resource throws rather than falling back
+    SPSC<std::uint64_t, WaitPolicy::NoWaits> overflow;
+    EXPECT_THROW(overflow.Allocate(allocator, 10000), std::bad_alloc);
+}
+
+TEST(PmrAllocatorTest, PoolResourceReusesBlocks) {
+    CountingResource                      upstream;
+    std::pmr::unsynchronized_pool_resource resource(&upstream);
+    PmrAllocator                          allocator(&resource);
+
+    // Recreating same-sized rings is served from the pool, without new upstream requests
+    size_t numUpstream = 0;
+    for (int cycle = 0; cycle < 10; ++cycle) {
+        SPSC<std::uint64_t, WaitPolicy::NoWaits> queue;
+        queue.Allocate(allocator, 64);
+        Round_Trip(queue, 64);
+        queue.Free(allocator);
+        if (cycle == 0)
+            numUpstream = upstream.allocations.size();
+    }
+    EXPECT_GE(numUpstream, static_cast<size_t>(1));
+    EXPECT_EQ(upstream.allocations.size(), numUpstream);
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,167 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "PoolAllocators.hpp"
+#include "SPSC.hpp"
+
+// Pushes and pops enough items to wrap around the queue a few times
+void Round_Trip(SPSC<std::uint64_t, WaitPolicy::NoWaits>& aQueue, int aCapacity) {
+    std::vector<std::uint64_t> input(aCapacity / 2 + 1);
+    std::vector<std::uint64_t> output;
+    output.reserve(input.size());
+    for (std::uint64_t cycle = 0; cycle < 4; ++cycle) {
+        for (size_t i = 0; i < input.size(); ++i)
+            input[i] = cycle * input.size() + i;
+        EXPECT_TRUE(aQueue.Emplace_Multiple(std::span<std::uint64_t>(input)).empty());
+        aQueue.Pop_Multiple(output);
+        EXPECT_EQ(output, input);
+        output.clear();
+    }
+}
+
+bool Is_Aligned(const std::byte* aPointer, std::size_t aAlignment) {
+    return (reinterpret_cast<std::uintptr_t>(aPointer) % aAlignment) == 0;
+}
+
+TEST(SlabAllocatorTest, ReusesFreedBlocks) {
+    SlabAllocator allocator;
+
+    auto first = allocator.Allocate(1000, 64);
+    ASSERT_NE(first, nullptr);
+    EXPECT_TRUE(Is_Aligned(first, SlabAllocator::sBlockAlign));
+    EXPECT_EQ(allocator.allocated_count(), static_cast<size_t>(1));
+    allocator.Free(first, 1000, 64);
+    EXPECT_EQ(allocator.allocated_count(), static_cast<size_t>(0));
+
+    // Same size class: the block just freed comes straight back
+    auto second = allocator.Allocate(700, 64);
+    EXPECT_EQ(second, first);
+    allocator.Free(second, 700, 64);
+    EXPECT_EQ(allocator.slab_count(), static_cast<size_t>(1));
+}
+
+TEST(SlabAllocatorTest, BlocksDontOverlap) {
+    SlabAllocator           allocator;
+    std::vector<std::byte*> blocks;
+    for (int i = 0; i < 1000; ++i) {
+        auto cBlock = allocator.Allocate(256, 64);
+        EXPECT_TRUE(Is_Aligned(cBlock, SlabAllocator::sBlockAlign));
+        std::fill(cBlock, cBlock + 256, static_cast<std::byte>(i));
+        blocks.push_back(cBlock);
+    }
+    for (int i = 0; i < 1000; ++i) {
+        EXPECT_EQ(blocks[i][0], static_cast<std::byte>(i));
+        EXPECT_EQ(blocks[i][255], static_cast<std::byte>(i));
+        allocator.Free(blocks[i], 256, 64);
+    }
+    EXPECT_EQ(allocator.allocated_count(), static_cast<size_t>(0));
+}
+
+TEST(SlabAllocatorTest, LargeAndOverAlignedRequests) {
+    SlabAllocator allocator;
+
+    auto large = allocator.Allocate(SlabAllocator::sMaxBlockSize + 1, 64);
+    auto wide  = allocator.Allocate(128, 4096);
+    EXPECT_TRUE(Is_Aligned(wide, 4096));
+    EXPECT_EQ(allocator.allocated_count(), static_cast<size_t>(2));
+    EXPECT_EQ(allocator.slab_count(), static_cast<size_t>(0));
+
+    allocator.Free(large, SlabAllocator::sMaxBlockSize + 1, 64);
+    allocator.Free(wide, 128, 4096);
+    EXPECT_EQ(allocator.allocated_count(), static_cast<size_t>(0));
+}
+
+TEST(SlabAllocatorTest, QueueChurn) {
+    SlabAllocator allocator;
+    for (int cycle = 0; cycle < 3; ++cycle) {
+        std::vector<std::unique_ptr<SPSC<std::uint64_t, WaitPolicy::NoWaits>>> queues;
+        for (int i = 0; i < 100; ++i) {
+            queues.push_back(std::make_unique<SPSC<std::uint64_t, WaitPolicy::NoWaits>>());
+            queues.back()->Allocate(allocator, 16 + i);
+            Round_Trip(*queues.back(), 16 + i);
+        }
+        EXPECT_EQ(allocator.allocated_count(), static_cast<size_t>(100));
+        for (auto& queue : queues)
+            queue->Free(allocator);
+        EXPECT_EQ(allocator.allocated_count(), static_cast<size_t>(0));
+    }
+
+    // The later cycles didn't need any new slabs
+    auto numSlabs = allocator.slab_count();
+    SPSC<std::uint64_t, WaitPolicy::NoWaits> queue;
+    queue.Allocate(allocator, 50);
+    queue.Free(allocator);
+    EXPECT_EQ(allocator.slab_count(), numSlabs);
+}
+
+TEST(ArenaAllocatorTest, BumpsAndRewinds) {
+    ArenaAllocator allocator(4096);
+
+    auto first  = allocator.Allocate(100, 64);
+    auto second = allocator.Allocate(100, 64);
+    EXPECT_TRUE(Is_Aligned(first, 64));
+    EXPECT_TRUE(Is_Aligned(second, 64));
+    EXPECT_GE(second, first + 100);
+    EXPECT_EQ(allocator.allocated_count(), static_cast<size_t>(2));
+
+    // Memory only comes back once everything is freed
+    allocator.Free(first, 100, 64);
+    auto third = allocator.Allocate(100, 64);
+    EXPECT_GT(third, second);
+    allocator.Free(second, 100, 64);
+    allocator.Free(third, 100, 64);
+    EXPECT_EQ(allocator.allocated_count(), static_cast<size_t>(0));
+
+    EXPECT_EQ(allocator.Allocate(100, 64), first);
+}
+
+TEST(ArenaAllocatorTest, GrowsAndReusesChunks) {
+    ArenaAllocator allocator(4096);
+
+    std::vector<std::byte*> blocks;
+    for (int i = 0; i < 20; ++i)
+        blocks.push_back(allocator.Allocate(1000, 64));
+    auto big = allocator.Allocate(10000, 4096);  // Bigger than a chunk
+    EXPECT_TRUE(Is_Aligned(big, 4096));
+    std::fill(big, big + 10000, std::byte{1});
+
+    auto numChunks = allocator.chunk_count();
+    EXPECT_GT(numChunks, static_cast<size_t>(5));
+
+    for (auto block : blocks)
+        allocator.Free(block, 1000, 64);
+    allocator.Free(big, 10000, 4096);
+
+    // The second cycle fits in the chunks of the first
+    for (int cycle = 0; cycle < 3; ++cycle) {
+        for (auto& block : blocks)
+            block = allocator.Allocate(1000, 64);
+        for (auto block : blocks)
+            allocator.Free(block, 1000, 64);
+    }
+    EXPECT_EQ(allocator.chunk_count(), numChunks);
+}
+
+TEST(ArenaAllocatorTest, QueueChurn) {
+    ArenaAllocator allocator;
+    for (int cycle = 0; cycle < 3; ++cycle) {
+        std::vector<std::unique_ptr<SPSC<std::uint64_t, WaitPolicy::NoWaits>>> queues;
+        for (int i = 0; i < 100; ++i) {
+            queues.push_back(std::make_unique<SPSC<std::uint64_t, WaitPolicy::NoWaits>>());
+            queues.back()->Allocate(allocator, 16 + i);
+            Round_Trip(*queues.back(), 16 + i);
+        }
+        for (auto& queue : queues)
+            queue->Free(allocator);
+    }
+    EXPECT_EQ(allocator.allocated_count(), static_cast<size_t>(0));
+    EXPECT_EQ(allocator.chunk_count(), static_cast<size_t>(1));
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,206 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "SPSC.hpp"
+#include "test_allocator.hpp"
+
+// Disabled stats take no space
+static_assert(std::is_empty_v<NoQueueCounters>);
+static_assert(sizeof(SPSC<int, WaitPolicy::NoWaits>) <
+              sizeof(SPSC<int, WaitPolicy::NoWaits, StatsPolicy::Counters>));
+
+TEST(QueueStatsTest, CountsSuccessesAndRejections) {
+    TestAllocator                                         allocator;
+    SPSC<int, WaitPolicy::NoWaits, StatsPolicy::Counters> queue;
+    queue.Allocate(allocator, 4);
+
+    int value;
+    EXPECT_FALSE(queue.Pop(value));
+    for (int i = 0; i < 5; ++i)
+        queue.Emplace(i);  // The last one is rejected
+
+    auto stats = queue.stats();
+    EXPECT_EQ(stats.pushes, 4u);
+    EXPECT_EQ(stats.full_rejections, 1u);
+    EXPECT_EQ(stats.high_water_mark, 4u);
+    EXPECT_EQ(stats.empty_rejections, 1u);
+    EXPECT_EQ(stats.pops, 0u);
+
+    EXPECT_TRUE(queue.Pop(value));
+    std::vector<int> output;
+    output.reserve(10);
+    queue.Pop_Multiple(output);
+    queue.Pop_Multiple(output);  // Empty
+
+    stats = queue.stats();
+    EXPECT_EQ(stats.pops, 4u);
+    EXPECT_EQ(stats.empty_rejections, 2u);
+
+    // Batches count every item, and a rejection only when nothing fit
+    std::vector<int> input = {1, 2, 3, 4, 5, 6};
+    auto             rest  = queue.Emplace_Multiple(std::span<int>(input));
+    EXPECT_EQ(rest.size(), 2u);
+    queue.Emplace_Multiple(rest);
+
+    stats = queue.stats();
+    EXPECT_EQ(stats.pushes, 8u);
+    EXPECT_EQ(stats.full_rejections, 2u);
+    EXPECT_EQ(stats.high_water_mark, 4u);
+
+    // An output container without room isn't an empty queue
+    std::vector<int> full;
+    queue.Pop_Multiple(full);
+    EXPECT_EQ(queue.stats().empty_rejections, 2u);
+
+    output.clear();
+    queue.Pop_Multiple(output);
+    queue.Free(allocator);
+}
+
+TEST(QueueStatsTest, CountsWaitsAndWakeups) {
+    constexpr int NUM_ITEMS = 20000;
+
+    TestAllocator                                           allocator;
+    SPSC<int, WaitPolicy::BothAwait, StatsPolicy::Counters> queue;
+    queue.Allocate(allocator, 4);
+
+    std::atomic<bool> done{false};
+
+    // A monitoring thread reads the counters while they're updated
+    std::thread monitor([&]() {
+        std::uint64_t lastPushes = 0;
+        while (!done.load()) {
+            auto stats = queue.stats();
+            EXPECT_GE(stats.pushes, lastPushes);
+            EXPECT_LE(stats.high_water_mark, 4u);
+            lastPushes = stats.pushes;
+        }
+    });
+
+    std::thread producer([&]() {
+        for (int i = 0; i < NUM_ITEMS; ++i)
+            queue.Emplace_Await(i);
+    });
+
+    int sum = 0;
+    int value;
+    for (int i = 0; i < NUM_ITEMS; ++i) {
+        ASSERT_TRUE(queue.Pop_Await(value));
+        sum += (value == i) ? 1 : 0;
+    }
+    producer.join();
+    done = true;
+    monitor.join();
+    EXPECT_EQ(sum, NUM_ITEMS);
+
+    auto stats = queue.stats();
+    EXPECT_EQ(stats.pushes, static_cast<std::uint64_t>(NUM_ITEMS));
+    EXPECT_EQ(stats.pops, static_cast<std::uint64_t>(NUM_ITEMS));
+    EXPECT_EQ(stats.high_water_mark, 4u);
+
+    // Every failed attempt in an await loop is followed by a wait
+    EXPECT_EQ(stats.push_waits, stats.full_rejections);
+    EXPECT_EQ(stats.pop_waits, stats.empty_rejections);
+
+    // A waiting side can only have been woken by a notify from the other
+    if (stats.pop_waits > 0) {
+        EXPECT_GT(stats.consumer_wakeups, 0u);
+    }
+    if (stats.push_waits > 0) {
+        EXPECT_GT(stats.producer_wakeups, 0u);
+    }
+
+    queue.Free(allocator);
+}
+
+TEST(LatencyHistogramTest, BucketBoundaries) {
+    // Exact below the first power of two that is split into sub-buckets
+    for (std::uint64_t value = 0; value < LatencyHistogram::sSubBuckets; ++value) {
+        auto bucket = LatencyHistogram::Bucket_Index(value);
+        EXPECT_EQ(LatencyHistogram::Bucket_Upper_Bound(bucket), value);
+    }
+
+    // Above that, each value lies in its bucket, within the relative error bound
+    for (std::uint64_t value : {16ull, 17ull, 100ull, 1000ull, 123456789ull, ~0ull}) {
+        auto bucket     = LatencyHistogram::Bucket_Index(value);
+        auto upperBound = LatencyHistogram::Bucket_Upper_Bound(bucket);
+        ASSERT_LT(bucket, LatencyHistogram::sNumBuckets);
+        EXPECT_GE(upperBound, value);
+        EXPECT_LE(upperBound - value, value / LatencyHistogram::sSubBuckets);
+        if (bucket > 0) {
+            EXPECT_LT(LatencyHistogram::Bucket_Upper_Bound(bucket - 1), value);
+        }
+    }
+}
+
+TEST(LatencyHistogramTest, Percentiles) {
+    LatencyHistogram histogram;
+    EXPECT_EQ(histogram.Percentile(0.5), 0u);
+
+    for (std::uint64_t value = 1; value <= 1000; ++value)
+        histogram.Record(value);
+    histogram.Record(1000000);
+
+    EXPECT_EQ(histogram.count(), 1001u);
+    EXPECT_EQ(histogram.max(), 1000000u);
+    EXPECT_NEAR(static_cast<double>(histogram.Percentile(0.5)), 500.0, 500.0 / 16);
+    EXPECT_NEAR(static_cast<double>(histogram.Percentile(0.99)), 990.0, 990.0 / 16);
+    EXPECT_EQ(histogram.Percentile(1.0), 1000000u);
+}
+
+TEST(QueueLatencyTest, TracesPushToPopTime) {
+    TestAllocator                                        allocator;
+    SPSC<int, WaitPolicy::NoWaits, StatsPolicy::Latency> queue;
+    queue.Allocate(allocator, 8);
+    EXPECT_EQ(allocator.allocated_count(), 2u);  // Slots and timestamps
+
+    EXPECT_TRUE(queue.Emplace(1));
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    int value;
+    EXPECT_TRUE(queue.Pop(value));
+
+    auto latency = queue.latency();
+    EXPECT_EQ(latency.count, 1u);
+    EXPECT_GE(latency.max, 4e6);
+    EXPECT_LT(latency.max, 1e9);
+
+    queue.Free(allocator);
+    EXPECT_EQ(allocator.allocated_count(), 0u);
+}
+
+TEST(QueueLatencyTest, BatchesWrapAround) {
+    TestAllocator                                    allocator;
+    SPSC<int, WaitPolicy::NoWaits, StatsPolicy::All> queue;
+    queue.Allocate(allocator, 7);
+
+    std::vector<int> input = {1, 2, 3, 4, 5};
+    std::vector<int> output;
+    output.reserve(input.size());
+    for (int cycle = 0; cycle < 10; ++cycle) {
+        EXPECT_TRUE(queue.Emplace_Multiple(std::span<int>(input)).empty());
+        queue.Pop_Multiple(output);
+        EXPECT_EQ(output, input);
+        output.clear();
+    }
+
+    // Counters and latency are both tracked
+    EXPECT_EQ(queue.stats().pops, 50u);
+    auto latency = queue.latency();
+    EXPECT_EQ(latency.count, 50u);
+    EXPECT_LE(latency.p50, latency.p99);
+    EXPECT_LE(latency.p99, latency.p999);
+    EXPECT_LE(latency.p999, latency.max);
+    EXPECT_LT(latency.max, 1e9);
+
+    queue.Free(allocator);
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,151 @@
+#include <gtest/gtest.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "SharedSPSC.hpp"
+
+// Messages crossing the process boundary must be trivially copyable
+struct Tick {
+    long   sequence;
+    double price;
+};
+
+// Test fixture for shared memory queue tests
+class SharedSPSCTest : public ::testing::Test {
+  protected:
+    void SetUp() override { name_ = "/spsc_test_" + std::to_string(getpid()); }
+
+    // Runs aChild in a forked process, returns its exit code
+    template <typename ChildType>
+    static pid_t Fork_Child(ChildType aChild) {
+        auto pid = fork();
+        if (pid == 0)
+            _exit(aChild());  // No destructors: the parent owns the segment
+        return pid;
+    }
+
+    static int Wait_Child(pid_t pid) {
+        int status = 0;
+        waitpid(pid, &status, 0);
+        return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+    }
+
+    std::string name_;
+};
+
+TEST_F(SharedSPSCTest, CreateAndAttachInSameProcess) {
+    auto producer = SharedSPSC<Tick>::Create(name_, 4);
+    auto consumer = SharedSPSC<Tick>::Attach(name_);
+    EXPECT_TRUE(producer.Is_Attached());
+    EXPECT_TRUE(consumer.Is_Attached());
+    EXPECT_EQ(consumer.capacity(), 4);
+
+    // Both handles map the segment at different addresses: storage is located by offset
+    for (long i = 0; i < 4; ++i) {
+        EXPECT_TRUE(producer.Emplace(Tick{i, i * 1.5}));
+    }
+    EXPECT_FALSE(producer.Emplace(Tick{99, 0.0}));
+    EXPECT_EQ(consumer.size(), static_cast<size_t>(4));
+
+    Tick tick;
+    for (long i = 0; i < 4; ++i) {
+        EXPECT_TRUE(consumer.Pop(tick));
+        EXPECT_EQ(tick.sequence, i);
+        EXPECT_DOUBLE_EQ(tick.price, i * 1.5);
+    }
+    EXPECT_FALSE(consumer.Pop(tick));
+    EXPECT_TRUE(producer.empty());
+}
+
+TEST_F(SharedSPSCTest, BatchOperationsWrapAround) {
+    auto queue = SharedSPSC<int>::Create_Anonymous(5);
+
+    std::vector<int> input = {1, 2, 3};
+    std::vector<int> output;
+    output.reserve(5);
+    for (int cycle = 0; cycle < 4; ++cycle) {
+        EXPECT_TRUE(queue.Emplace_Multiple(input).empty());
+        queue.Pop_Multiple(output);
+        EXPECT_EQ(output, input);
+        output.clear();
+    }
+}
+
+TEST_F(SharedSPSCTest, AttachFailures) {
+    EXPECT_THROW(SharedSPSC<int>::Attach(name_), std::system_error);
+
+    // Attaching with a different element type is rejected
+    auto queue = SharedSPSC<Tick>::Create(name_, 4);
+    EXPECT_THROW(SharedSPSC<int>::Attach(name_), std::runtime_error);
+
+    // Creating over an existing segment is rejected
+    EXPECT_THROW(SharedSPSC<Tick>::Create(name_, 4), std::system_error);
+}
+
+TEST_F(SharedSPSCTest, TwoProcessesNamedSegment) {
+    using TickQueue = SharedSPSC<Tick, WaitPolicy::BothAwait>;
+    constexpr long NUM_ITEMS = 100000;
+
+    auto consumer = TickQueue::Create(name_, 64);
+
+    // Producer process attaches by name and blocks whenever the queue is full
+    auto name  = name_;
+    auto child = Fork_Child([&name]() {
+        auto producer = TickQueue::Attach(name);
+        for (long i = 0; i < NUM_ITEMS; ++i)
+            producer.Emplace_Await(Tick{i, static_cast<double>(i)});
+        producer.End_PopWaiting();
+        return 0;
+    });
+
+    long received = 0;
+    bool in_order = true;
+    Tick tick;
+    while (consumer.Pop_Await(tick)) {
+        in_order &= (tick.sequence == received) && (tick.price == static_cast<double>(received));
+        ++received;
+    }
+
+    EXPECT_EQ(Wait_Child(child), 0);
+    EXPECT_TRUE(in_order);
+    EXPECT_EQ(received, NUM_ITEMS);
+}
+
+TEST_F(SharedSPSCTest, TwoProcessesAnonymousSegment) {
+    using IntQueue = SharedSPSC<int, WaitPolicy::PopAwait>;
+    constexpr int NUM_ITEMS = 10000;
+
+    auto queue = IntQueue::Create_Anonymous(NUM_ITEMS);
+
+    // Consumer process attaches through the inherited memfd
+    auto fd    = queue.Fd();
+    auto child = Fork_Child([fd]() {
+        auto consumer = IntQueue::Attach(fd);
+        int  value    = 0;
+        int  expected = 0;
+        while (consumer.Pop_Await(value)) {
+            if (value != expected++)
+                return 1;
+        }
+        return (expected == NUM_ITEMS) ? 0 : 2;
+    });
+
+    std::vector<int> batch(100);
+    for (int i = 0; i < NUM_ITEMS; i += 100) {
+        for (int j = 0; j < 100; ++j)
+            batch[j] = i + j;
+        EXPECT_TRUE(queue.Emplace_Multiple(batch).empty());
+    }
+    queue.End_PopWaiting();
+
+    EXPECT_EQ(Wait_Child(child), 0);
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
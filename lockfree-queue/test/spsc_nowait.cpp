@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 
+#include <bit>
 #include <chrono>
 #include <memory>
 #include <random>
@@ -54,6 +55,28 @@ TEST_F(SPSCQueueTest, AllocationAndDeallocation) {
     EXPECT_EQ(allocator_->allocated_count(), static_cast<size_t>(0));
 }
 
+TEST_F(SPSCQueueTest, DefaultCapacityFitsInL2) {
+    Queue<int, ThreadsPolicy::SPSC, WaitPolicy::NoWaits> queue;
+    queue.Allocate(*allocator_);
+
+    int numPushed = 0;
+    while (queue.Emplace(numPushed))
+        ++numPushed;
+    EXPECT_EQ(numPushed, Default_Capacity(sizeof(int)));
+    EXPECT_TRUE(std::has_single_bit(static_cast<unsigned>(numPushed)));
+
+    auto l2Size = hw_utils::System_Topology().l2_size;
+    if (l2Size > 0) {
+        EXPECT_LE(numPushed * sizeof(int), l2Size / 2);
+        EXPECT_GT(2 * numPushed * sizeof(int), l2Size / 2);
+    }
+
+    int value;
+    while (queue.Pop(value))
+        ;
+    queue.Free(*allocator_);
+}
+
 TEST_F(SPSCQueueTest, InvalidAllocation) {
     Queue<int, ThreadsPolicy::SPSC, WaitPolicy::NoWaits> queue;
 
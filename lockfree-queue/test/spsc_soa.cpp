@@ -0,0 +1,173 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <numeric>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include "SPSC_SoA.hpp"
+#include "test_allocator.hpp"
+
+// A 3-column row: id, price, quantity
+using Row = std::tuple<std::uint64_t, double, int>;
+
+// Test fixture for structure-of-arrays queue tests
+class SoAQueueTest : public ::testing::Test {
+  protected:
+    void SetUp() override { allocator_ = std::make_unique<TestAllocator>(); }
+
+    void TearDown() override {
+        if (queue_.Is_Allocated()) {
+            queue_.Free(*allocator_);
+        }
+    }
+
+    std::unique_ptr<TestAllocator> allocator_;
+    SPSC_SoA<Row>                  queue_;
+};
+
+TEST_F(SoAQueueTest, AllocationUsesSingleBlock) {
+    queue_.Allocate(*allocator_, 10);
+    EXPECT_TRUE(queue_.Is_Allocated());
+    EXPECT_TRUE(queue_.empty());
+    EXPECT_EQ(queue_.capacity(), 10);
+    EXPECT_EQ(allocator_->allocated_count(), static_cast<size_t>(1));
+
+    queue_.Free(*allocator_);
+    EXPECT_FALSE(queue_.Is_Allocated());
+    EXPECT_EQ(allocator_->allocated_count(), static_cast<size_t>(0));
+}
+
+TEST_F(SoAQueueTest, InvalidAllocation) {
+    EXPECT_DEATH(queue_.Allocate(*allocator_, 0), "Invalid capacity");
+}
+
+TEST_F(SoAQueueTest, SingleRowOperations) {
+    queue_.Allocate(*allocator_, 2);
+
+    EXPECT_TRUE(queue_.Emplace(1, 10.5, 100));
+    EXPECT_TRUE(queue_.Emplace(2, 20.5, 200));
+    EXPECT_FALSE(queue_.Emplace(3, 30.5, 300));  // Full
+    EXPECT_EQ(queue_.size(), static_cast<size_t>(2));
+
+    std::uint64_t id;
+    double        price;
+    int           quantity;
+    EXPECT_TRUE(queue_.Pop(id, price, quantity));
+    EXPECT_EQ(id, 1u);
+    EXPECT_DOUBLE_EQ(price, 10.5);
+    EXPECT_EQ(quantity, 100);
+
+    EXPECT_TRUE(queue_.Pop(id, price, quantity));
+    EXPECT_EQ(id, 2u);
+    EXPECT_FALSE(queue_.Pop(id, price, quantity));  // Empty
+}
+
+TEST_F(SoAQueueTest, MultipleColumnsWrapAround) {
+    queue_.Allocate(*allocator_, 8);
+
+    std::vector<std::uint64_t>   ids(6);
+    std::vector<double>          prices(6);
+    std::vector<int>             quantities(6);
+    std::array<std::uint64_t, 8> out_ids;
+    std::array<double, 8>        out_prices;
+    std::array<int, 8>           out_quantities;
+
+    // Repeated pushes of 6 rows into a capacity of 8 force the columns to wrap around
+    for (int cycle = 0; cycle < 5; ++cycle) {
+        std::iota(ids.begin(), ids.end(), cycle * 6);
+        for (int i = 0; i < 6; ++i) {
+            prices[i]     = (cycle * 6 + i) * 0.5;
+            quantities[i] = -(cycle * 6 + i);
+        }
+
+        EXPECT_EQ(queue_.Emplace_Multiple(ids, prices, quantities), 6);
+        EXPECT_EQ(queue_.size(), static_cast<size_t>(6));
+
+        EXPECT_EQ(queue_.Pop_Multiple(out_ids, out_prices, out_quantities), 6);
+        for (int i = 0; i < 6; ++i) {
+            EXPECT_EQ(out_ids[i], static_cast<std::uint64_t>(cycle * 6 + i));
+            EXPECT_DOUBLE_EQ(out_prices[i], (cycle * 6 + i) * 0.5);
+            EXPECT_EQ(out_quantities[i], -(cycle * 6 + i));
+        }
+        EXPECT_TRUE(queue_.empty());
+    }
+}
+
+TEST_F(SoAQueueTest, PartialBatches) {
+    queue_.Allocate(*allocator_, 4);
+
+    std::vector<std::uint64_t> ids        = {1, 2, 3, 4, 5, 6};
+    std::vector<double>        prices     = {1, 2, 3, 4, 5, 6};
+    std::vector<int>           quantities = {1, 2, 3, 4, 5, 6};
+
+    // Only 4 rows fit
+    EXPECT_EQ(queue_.Emplace_Multiple(ids, prices, quantities), 4);
+
+    // Pop is limited by the shortest output column
+    std::array<std::uint64_t, 4> out_ids;
+    std::array<double, 3>        out_prices;
+    std::array<int, 4>           out_quantities;
+    EXPECT_EQ(queue_.Pop_Multiple(out_ids, out_prices, out_quantities), 3);
+    EXPECT_EQ(out_ids[2], 3u);
+    EXPECT_EQ(queue_.size(), static_cast<size_t>(1));
+
+    EXPECT_EQ(queue_.Pop_Multiple(out_ids, out_prices, out_quantities), 1);
+    EXPECT_EQ(out_ids[0], 4u);
+    EXPECT_EQ(queue_.Pop_Multiple(out_ids, out_prices, out_quantities), 0);
+}
+
+TEST_F(SoAQueueTest, MismatchedColumnLengths) {
+    queue_.Allocate(*allocator_, 4);
+
+    std::vector<std::uint64_t> ids        = {1, 2};
+    std::vector<double>        prices     = {1};
+    std::vector<int>           quantities = {1, 2};
+    EXPECT_DEATH(queue_.Emplace_Multiple(ids, prices, quantities), "same length");
+}
+
+TEST_F(SoAQueueTest, ConcurrentBatchesWithPopAwait) {
+    using PairRow = std::tuple<int, float>;
+    SPSC_SoA<PairRow, WaitPolicy::BothAwait> queue;
+    queue.Allocate(*allocator_, 64);
+
+    constexpr int NUM_ITEMS = 100000;
+
+    std::thread producer([&queue]() {
+        std::array<int, 16>   keys;
+        std::array<float, 16> values;
+        for (int i = 0; i < NUM_ITEMS; i += 16) {
+            for (int j = 0; j < 16; ++j) {
+                keys[j]   = i + j;
+                values[j] = static_cast<float>(i + j);
+            }
+            queue.Emplace_Multiple_Await(keys, values);
+        }
+        queue.End_PopWaiting();
+    });
+
+    std::vector<int>      consumed;
+    std::array<int, 32>   keys;
+    std::array<float, 32> values;
+    bool                  in_order = true;
+    while (int num_popped = queue.Pop_Multiple_Await(keys, values)) {
+        for (int i = 0; i < num_popped; ++i) {
+            in_order &= (keys[i] == static_cast<int>(consumed.size()));
+            in_order &= (values[i] == static_cast<float>(keys[i]));
+            consumed.push_back(keys[i]);
+        }
+    }
+    producer.join();
+
+    EXPECT_TRUE(in_order);
+    EXPECT_EQ(consumed.size(), static_cast<size_t>(NUM_ITEMS));
+    queue.Free(*allocator_);
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+
+// Layout of binary log files (BinaryLog.hpp), shared with the decoder (log_decode.cpp). A file is
+// a sequence of records, each starting with a one-byte tag. Integers are in the writer's native
+// byte order, which the header records.
+//
+//   Header: 'H', "RLOGBIN", version (u8), timestamp precision (u8), sBinaryByteOrderMark (u32)
+//   Format: 'F', format id (u32), number of arguments (u8), argument types (u8 each),
+//           format string length (u32), format string
+//   Entry:  'E', format id (u32), nanoseconds since the epoch (i64), arguments
+//
+// Each process that opens the file appends a header: format ids are per process, so a header
+// forgets all earlier formats. A format is written once per header, before its first entry.
+// Arguments are written raw, per the format's argument types: Int (i64), UInt (u64), Double
+// (f64), Bool and Char (one byte), String (length (u32) and bytes).
+namespace binary_log {
+
+constexpr char          sHeaderTag           = 'H';
+constexpr char          sFormatTag           = 'F';
+constexpr char          sEntryTag            = 'E';
+constexpr char          sMagic[]             = "RLOGBIN";  // Without its null terminator
+constexpr std::uint8_t  sVersion             = 1;
+constexpr std::uint32_t sBinaryByteOrderMark = 0x01020304;
+
+enum class ArgType : std::uint8_t { Int = 1, UInt, Double, Bool, Char, String };
+
+// How an argument of type ArgumentType is stored
+template <typename ArgumentType>
+constexpr ArgType Arg_Type() {
+    using Type = std::remove_cvref_t<ArgumentType>;
+    if constexpr (std::is_same_v<Type, bool>)
+        return ArgType::Bool;
+    else if constexpr (std::is_same_v<Type, char>)
+        return ArgType::Char;
+    else if constexpr (std::is_integral_v<Type> && std::is_signed_v<Type>)
+        return ArgType::Int;
+    else if constexpr (std::is_integral_v<Type>)
+        return ArgType::UInt;
+    else if constexpr (std::is_floating_point_v<Type>)
+        return ArgType::Double;
+    else {
+        static_assert(std::is_convertible_v<const Type&, std::string_view>,
+                      "Binary log arguments: integers, floating point, bool, char or strings");
+        return ArgType::String;
+    }
+}
+
+}  // namespace binary_log
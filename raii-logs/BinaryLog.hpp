@@ -0,0 +1,207 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "BinaryFormat.hpp"
+#include "LogFile.hpp"
+
+// Binary logging with deferred formatting: each call site registers its format string once, and
+// a log call only copies the format's id, a timestamp and the raw arguments into the log. Text is
+// made offline, by log_decode. No number-to-text conversion, no locale, no string building on the
+// logging thread: in async mode a call is a clock read and a copy into the ring.
+//
+//   BinaryLogFile log("app.rlog", {.mode = LogMode::Async});
+//   BINARY_LOG(log, "Order {} filled at {} ({})", orderId, price, venue);
+//
+// Placeholders are "{}", filled with the arguments in order ("{{" and "}}" for braces). Arguments
+// are integers, floating point (stored as double), bool, char or strings (copied).
+
+// Process-wide format string registry: ids are indices, stable for the life of the process
+class BinaryFormats {
+  public:
+    // Once per call site (see BINARY_LOG). aFormat must outlive the process (a string literal).
+    static std::uint32_t Register(const char* aFormat) {
+        std::lock_guard cLock(Mutex());
+        Formats().push_back(aFormat);
+        return static_cast<std::uint32_t>(Formats().size() - 1);
+    }
+
+    static const char* Get(std::uint32_t aFormatId) {
+        std::lock_guard cLock(Mutex());
+        return Formats()[aFormatId];
+    }
+
+  private:
+    static std::mutex& Mutex() {
+        static std::mutex sMutex;
+        return sMutex;
+    }
+    static std::deque<const char*>& Formats() {
+        static std::deque<const char*> sFormats;
+        return sFormats;
+    }
+};
+
+class BinaryLogFile {
+  public:
+    // The timestamp precision is only recorded, for the decoder: entries keep nanoseconds.
+    // No rotation: a file split anywhere but at a header couldn't be decoded.
+    BinaryLogFile(const std::string& aName, const LogOptions& aOptions = {})
+        : mWriter(Open_Sink(Unrotated(aOptions).sink, aName), aOptions.mode, aOptions.queue_bytes,
+                  aOptions.durability, aOptions.group),
+          mPrecision(aOptions.precision) {
+        Write_Header();
+        static const auto sOpened = BinaryFormats::Register("LOG OPENED");
+        Log(sOpened);
+    }
+
+    // Best effort: destructors can't throw
+    ~BinaryLogFile() {
+        try {
+            Close();
+        } catch (const std::exception&) {
+        }
+    }
+
+    BinaryLogFile(const BinaryLogFile&)            = delete;
+    BinaryLogFile& operator=(const BinaryLogFile&) = delete;
+
+    // Waits until every entry so far is on disk (see LogDurability). From the logging thread.
+    // Rethrows a write error of the async writer.
+    void Wait_Durable() { mWriter.Wait_Durable(); }
+
+    // As LogFile::Close(): LOG CLOSED is the last entry, and a write error is rethrown
+    void Close() {
+        if (mWriter.is_closed())
+            return;
+        static const auto sClosed = BinaryFormats::Register("LOG CLOSED");
+        Log(sClosed);
+        mWriter.Close();
+    }
+
+    // Not thread-safe: log from one thread at a time. The argument types must be the same on
+    // every call with the same format id (as they are from a BINARY_LOG call site).
+    template <typename... ArgumentTypes>
+    void Log(std::uint32_t aFormatId, const ArgumentTypes&... aArguments) {
+        if ((aFormatId >= mIsDefined.size()) || !mIsDefined[aFormatId])
+            Define_Format<ArgumentTypes...>(aFormatId);
+
+        // Sized once, then filled in place
+        auto         cNow        = Read_Clock(mPrecision);
+        std::int64_t cNanosecond = std::int64_t{cNow.tv_sec} * 1'000'000'000 + cNow.tv_nsec;
+        mRecord.resize(sizeof(binary_log::sEntryTag) + sizeof(aFormatId) + sizeof(cNanosecond) +
+                       (Argument_Size(aArguments) + ... + 0));
+
+        auto cCursor = mRecord.data();
+        cCursor      = Put(cCursor, binary_log::sEntryTag);
+        cCursor      = Put(cCursor, aFormatId);
+        cCursor      = Put(cCursor, cNanosecond);
+        ((cCursor = Put_Argument(cCursor, aArguments)), ...);
+        mWriter.Write(mRecord);
+    }
+
+  private:
+    // Checked before the file is opened
+    static const LogOptions& Unrotated(const LogOptions& aOptions) {
+        if (aOptions.rotation.Is_Enabled())
+            throw std::invalid_argument("Binary logs can't be rotated");
+        return aOptions;
+    }
+
+    void Write_Header() {
+        mRecord.clear();
+        Append(binary_log::sHeaderTag);
+        Append_Bytes(binary_log::sMagic, sizeof(binary_log::sMagic) - 1);
+        Append(binary_log::sVersion);
+        Append(static_cast<std::uint8_t>(mPrecision));
+        Append(binary_log::sBinaryByteOrderMark);
+        mWriter.Write(mRecord);
+    }
+
+    template <typename... ArgumentTypes>
+    void Define_Format(std::uint32_t aFormatId) {
+        static_assert(sizeof...(ArgumentTypes) < 256, "Too many arguments!");
+        std::string_view cFormat = BinaryFormats::Get(aFormatId);
+
+        mRecord.clear();
+        Append(binary_log::sFormatTag);
+        Append(aFormatId);
+        Append(static_cast<std::uint8_t>(sizeof...(ArgumentTypes)));
+        (Append(binary_log::Arg_Type<ArgumentTypes>()), ...);
+        Append(static_cast<std::uint32_t>(cFormat.size()));
+        Append_Bytes(cFormat.data(), cFormat.size());
+        mWriter.Write(mRecord);
+
+        if (aFormatId >= mIsDefined.size())
+            mIsDefined.resize(aFormatId + 1, false);
+        mIsDefined[aFormatId] = true;
+    }
+
+    void Append_Bytes(const void* aBytes, std::size_t aSize) {
+        auto cOffset = mRecord.size();
+        mRecord.resize(cOffset + aSize);
+        std::memcpy(mRecord.data() + cOffset, aBytes, aSize);
+    }
+
+    template <typename ValueType>
+    void Append(const ValueType& aValue) {
+        Append_Bytes(&aValue, sizeof(aValue));
+    }
+
+    template <typename ValueType>
+    static char* Put(char* aCursor, const ValueType& aValue) {
+        std::memcpy(aCursor, &aValue, sizeof(aValue));
+        return aCursor + sizeof(aValue);
+    }
+
+    template <typename ArgumentType>
+    static std::size_t Argument_Size(const ArgumentType& aArgument) {
+        using enum binary_log::ArgType;
+        constexpr auto cType = binary_log::Arg_Type<ArgumentType>();
+        if constexpr ((cType == Bool) || (cType == Char))
+            return sizeof(char);
+        else if constexpr (cType == String)
+            return sizeof(std::uint32_t) + std::string_view(aArgument).size();
+        else
+            return sizeof(std::uint64_t);
+    }
+
+    template <typename ArgumentType>
+    static char* Put_Argument(char* aCursor, const ArgumentType& aArgument) {
+        using enum binary_log::ArgType;
+        constexpr auto cType = binary_log::Arg_Type<ArgumentType>();
+        if constexpr ((cType == Bool) || (cType == Char))
+            return Put(aCursor, static_cast<char>(aArgument));
+        else if constexpr (cType == Int)
+            return Put(aCursor, static_cast<std::int64_t>(aArgument));
+        else if constexpr (cType == UInt)
+            return Put(aCursor, static_cast<std::uint64_t>(aArgument));
+        else if constexpr (cType == Double)
+            return Put(aCursor, static_cast<double>(aArgument));
+        else {
+            std::string_view cString = aArgument;
+            aCursor = Put(aCursor, static_cast<std::uint32_t>(cString.size()));
+            std::memcpy(aCursor, cString.data(), cString.size());
+            return aCursor + cString.size();
+        }
+    }
+
+    LogWriter          mWriter;
+    TimestampPrecision mPrecision;
+    std::vector<bool>  mIsDefined;  // By format id: written to this file yet?
+    std::vector<char>  mRecord;     // Reused: no allocation once grown
+};
+
+// Registers the format string on the call site's first execution, then logs the arguments
+#define BINARY_LOG(aLog, aFormat, ...)                                                             \
+    do {                                                                                           \
+        static const auto sFormatId = BinaryFormats::Register(aFormat);                            \
+        (aLog).Log(sFormatId __VA_OPT__(, ) __VA_ARGS__);                                          \
+    } while (false)
@@ -1,42 +1,127 @@
-#include <fstream>
-#include <iostream>
+#pragma once
+
+#include <cstddef>
+#include <exception>
 #include <string>
+#include <string_view>
+
+#include "LogFormat.hpp"
+#include "LogLevel.hpp"
+#include "LogWriter.hpp"
+#include "Timestamp.hpp"
 
 /**
- * @file File.hpp
+ * @file LogFile.hpp
  * @brief RAII wrapper for file handling in C++
  */
-class LogFile {
-    std::string  filename;
-    std::fstream fileStream;
 
+struct LogOptions {
+    LogMode            mode        = LogMode::Sync;
+    SinkType           sink        = SinkType::Stream;
+    int                queue_bytes = Default_Capacity(sizeof(char));  // Async ring: half the L2
+    TimestampPrecision precision   = TimestampPrecision::Seconds;
+    Rotation           rotation{};                     // Text logs only
+    LogLevel           level       = LogLevel::Trace;  // Runtime threshold, for leveled records
+    LogDurability      durability  = LogDurability::Buffered;
+    GroupCommit        group{};  // LogDurability::Group only
+};
+
+// Ends the record whose message starts at aMessageStart with exactly one newline, dropping the
+// message's own ("\n" or "\r\n")
+inline void End_Record(std::string& aRecord, std::size_t aMessageStart) {
+    if ((aRecord.size() > aMessageStart) && (aRecord.back() == '\n')) {
+        aRecord.pop_back();
+        if ((aRecord.size() > aMessageStart) && (aRecord.back() == '\r'))
+            aRecord.pop_back();
+    }
+    aRecord.push_back('\n');
+}
+
+class LogFile {
   public:
-    LogFile(const std::string& name) : filename(name) {
-        fileStream.open(filename, std::ios::out | std::ios::app);
-        if (!fileStream.is_open()) {
-            throw std::runtime_error("Failed to open file: " + filename);
-        }
+    LogFile(const std::string& aName, const LogOptions& aOptions = {})
+        : mWriter(Open_Sink(aOptions.sink, aName, aOptions.rotation), aOptions.mode,
+                  aOptions.queue_bytes, aOptions.durability, aOptions.group),
+          mTimestamps(aOptions.precision), mThreshold(aOptions.level) {
         this->operator<<("LOG OPENED");
     }
 
+    // Best effort: destructors can't throw
     ~LogFile() {
-        if (fileStream.is_open()) {
-            this->operator<<("LOG CLOSED");
-            fileStream.close();
+        try {
+            Close();
+        } catch (const std::exception&) {
         }
     }
 
-    void operator<<(const std::string& data) {
-        if (fileStream.is_open()) {
-            std::time_t now = std::time(nullptr);
-            std::tm     tm  = *std::localtime(&now);
-            std::string d   = data;
-            if (!d.empty() && d.back() == '\n') {
-                d.pop_back();
-                if (!d.empty() && d.back() == '\r')
-                    d.pop_back();
-            }
-            fileStream << std::put_time(&tm, "[%Y-%m-%d %H:%M:%S] ") << d << "\n";
-        }
+    LogFile(const LogFile&)            = delete;
+    LogFile& operator=(const LogFile&) = delete;
+
+    // Not thread-safe: log from one thread at a time (or use MergedLogFile)
+    void operator<<(std::string_view aData) {
+        Start_Record({});
+        Finish_Record(aData);
+    }
+
+    // "[...] INFO  <data>", if aLevel is enabled. See LOG_AT, which skips building aData too.
+    void Log(LogLevel aLevel, std::string_view aData) {
+        if (!Is_Enabled(aLevel))
+            return;
+        Start_Record(Level_Tag(aLevel));
+        Finish_Record(aData);
     }
-};
\ No newline at end of file
+
+    // aFormat with its placeholders filled in, formatted straight into the record (Format_To):
+    // no allocation once the record buffer has grown
+    template <typename... ArgumentTypes>
+        requires(sizeof...(ArgumentTypes) > 0)
+    void Log(LogLevel aLevel, std::string_view aFormat, const ArgumentTypes&... aArguments) {
+        if (!Is_Enabled(aLevel))
+            return;
+        auto cMessageStart = Start_Record(Level_Tag(aLevel));
+        Format_To(mRecord, aFormat, aArguments...);
+        End_Record(mRecord, cMessageStart);
+        mWriter.Write(mRecord);
+    }
+
+    bool Is_Enabled(LogLevel aLevel) const { return mThreshold.Is_Enabled(aLevel); }
+
+    // Waits until every record so far is on disk (see LogDurability): with Group durability, a
+    // commit point. From the logging thread. Rethrows a write error of the async writer.
+    void Wait_Durable() { mWriter.Wait_Durable(); }
+
+    // Writes LOG CLOSED before the writer drains and closes the file, so it is always the last
+    // record. Rethrows a write error of the async writer (see LogWriter), which the destructor
+    // (closing it if this wasn't called) can't. Nothing can be logged after.
+    void Close() {
+        if (mWriter.is_closed())
+            return;
+        this->operator<<("LOG CLOSED");
+        mWriter.Close();
+    }
+
+    // May be called from any thread
+    void     Set_Level(LogLevel aLevel) { mThreshold.Set(aLevel); }
+    LogLevel level() const { return mThreshold.Get(); }
+
+  private:
+    // "[YYYY-mm-dd HH:MM:SS] <tag>": returns where the message starts
+    std::size_t Start_Record(std::string_view aTag) {
+        mRecord.assign(mTimestamps.Prefix());
+        mRecord.append(aTag);
+        return mRecord.size();
+    }
+
+    // Appends aData and a newline (not the data's own) and writes the record
+    void Finish_Record(std::string_view aData) {
+        auto cMessageStart = mRecord.size();
+        mRecord.append(aData);
+        End_Record(mRecord, cMessageStart);
+        mWriter.Write(mRecord);
+    }
+
+    LogWriter      mWriter;
+    TimestampCache mTimestamps;
+    LevelThreshold mThreshold;
+    std::string    mRecord;  // Reused: no allocation once grown
+};
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <charconv>
+#include <concepts>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#if __has_include(<format>)
+    #include <format>
+    #include <iterator>
+#endif
+
+// Formats a message straight into a record buffer (a log's reused std::string), so once the buffer
+// has grown, formatting allocates nothing: no temporary strings, no streams.
+//
+// "{}" takes the next argument, "{{" and "}}" are literal braces (as in binary logs), and a
+// placeholder without an argument, or a stray brace, is left as it is: a mismatched format never
+// throws, and nothing logged is lost. Arguments are integers, floating point, bool, char and
+// strings. With std::format (<format>, GCC 13+), aFormat may also use its format specs
+// ("{:.3f}", ...), and is written with std::vformat_to; if std::format rejects it, it is written
+// as above (specs left as they are).
+namespace log_format {
+
+#if defined(__cpp_lib_format)
+
+template <typename ArgumentType>
+void Append_Argument(std::string& aBuffer, const ArgumentType& aArgument) {
+    std::format_to(std::back_inserter(aBuffer), "{}", aArgument);
+}
+
+#else
+
+template <typename ValueType>
+void Append_Number(std::string& aBuffer, const ValueType& aValue) {
+    char cText[32];  // Any integer, or the shortest text that reads back as the same double
+    auto cResult = std::to_chars(cText, cText + sizeof(cText), aValue);
+    aBuffer.append(cText, cResult.ptr);
+}
+
+template <typename ArgumentType>
+void Append_Argument(std::string& aBuffer, const ArgumentType& aArgument) {
+    using Type = std::remove_cvref_t<ArgumentType>;
+    if constexpr (std::is_same_v<Type, bool>)
+        aBuffer.append(aArgument ? "true" : "false");
+    else if constexpr (std::is_same_v<Type, char>)
+        aBuffer.push_back(aArgument);
+    else if constexpr (std::is_integral_v<Type>)
+        Append_Number(aBuffer, aArgument);
+    else if constexpr (std::is_floating_point_v<Type>)
+        Append_Number(aBuffer, static_cast<double>(aArgument));
+    else {
+        static_assert(std::convertible_to<const Type&, std::string_view>, "Unsupported argument!");
+        aBuffer.append(std::string_view(aArgument));
+    }
+}
+
+#endif
+
+// The literal text of aFormat up to its next "{}" (unescaping "{{" and "}}"), and whether it
+// reached one. aFormat is left after the placeholder.
+inline bool Append_Until_Placeholder(std::string& aBuffer, std::string_view& aFormat) {
+    for (std::size_t cIndex = 0; cIndex < aFormat.size(); ++cIndex) {
+        auto cChar = aFormat[cIndex];
+        auto cNext = (cIndex + 1 < aFormat.size()) ? aFormat[cIndex + 1] : '\0';
+        if ((cChar == '{') && (cNext == '}')) {
+            aFormat.remove_prefix(cIndex + 2);
+            return true;
+        }
+        if (((cChar == '{') || (cChar == '}')) && (cNext == cChar))
+            ++cIndex;
+        aBuffer.push_back(cChar);
+    }
+    aFormat = {};
+    return false;
+}
+
+template <typename... ArgumentTypes>
+void Substitute(std::string& aBuffer, std::string_view aFormat,
+                const ArgumentTypes&... aArguments) {
+    ((Append_Until_Placeholder(aBuffer, aFormat) ? Append_Argument(aBuffer, aArguments) : void()),
+     ...);
+    while (Append_Until_Placeholder(aBuffer, aFormat))
+        aBuffer.append("{}");  // No argument left for it
+}
+
+}  // namespace log_format
+
+#if defined(__cpp_lib_format)
+
+template <typename... ArgumentTypes>
+void Format_To(std::string& aBuffer, std::string_view aFormat, const ArgumentTypes&... aArguments) {
+    auto cSize = aBuffer.size();
+    try {
+        std::vformat_to(std::back_inserter(aBuffer), aFormat, std::make_format_args(aArguments...));
+    } catch (const std::format_error&) {
+        aBuffer.resize(cSize);
+        log_format::Substitute(aBuffer, aFormat, aArguments...);
+    }
+}
+
+#else
+
+template <typename... ArgumentTypes>
+void Format_To(std::string& aBuffer, std::string_view aFormat, const ArgumentTypes&... aArguments) {
+    log_format::Substitute(aBuffer, aFormat, aArguments...);
+}
+
+#endif
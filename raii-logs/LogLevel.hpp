@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <string_view>
+
+// Severity of a record. Off is only a threshold: nothing is logged at it.
+enum class LogLevel { Trace, Debug, Info, Warn, Error, Off };
+
+// Statements below this level are compiled out (see LOG_AT): their arguments aren't even
+// evaluated. Set with -DRAII_LOGS_MIN_LEVEL=<level name>, e.g. Info for production builds.
+#if defined(RAII_LOGS_MIN_LEVEL)
+constexpr LogLevel sMinLogLevel = LogLevel::RAII_LOGS_MIN_LEVEL;
+#else
+constexpr LogLevel sMinLogLevel = LogLevel::Trace;
+#endif
+
+constexpr bool Is_Compiled_In(LogLevel aLevel) {
+    return (aLevel >= sMinLogLevel) && (aLevel != LogLevel::Off);
+}
+
+// "INFO " etc.: a fixed width, so messages line up
+constexpr std::string_view Level_Tag(LogLevel aLevel) {
+    switch (aLevel) {
+        case LogLevel::Trace:
+            return "TRACE ";
+        case LogLevel::Debug:
+            return "DEBUG ";
+        case LogLevel::Info:
+            return "INFO  ";
+        case LogLevel::Warn:
+            return "WARN  ";
+        case LogLevel::Error:
+            return "ERROR ";
+        default:
+            return "";
+    }
+}
+
+// A log's runtime threshold: records below it are dropped. May be changed from any thread.
+class LevelThreshold {
+  public:
+    explicit LevelThreshold(LogLevel aLevel) : mLevel(aLevel) {}
+
+    bool Is_Enabled(LogLevel aLevel) const {
+        return Is_Compiled_In(aLevel) && (aLevel >= mLevel.load(std::memory_order::relaxed));
+    }
+
+    void     Set(LogLevel aLevel) { mLevel.store(aLevel, std::memory_order::relaxed); }
+    LogLevel Get() const { return mLevel.load(std::memory_order::relaxed); }
+
+  private:
+    std::atomic<LogLevel> mLevel;
+};
+
+// Logs the message (whatever the log's Log() takes after the level) at aLevel, if enabled. Below
+// sMinLogLevel the statement compiles to nothing; below the log's threshold it is a relaxed load
+// and a branch. Either way the arguments aren't evaluated, so nothing is formatted or allocated.
+#define LOG_AT(aLog, aLevel, ...)                                                                  \
+    do {                                                                                           \
+        if constexpr (Is_Compiled_In(aLevel)) {                                                    \
+            if ((aLog).Is_Enabled(aLevel))                                                         \
+                (aLog).Log(aLevel, __VA_ARGS__);                                                   \
+        }                                                                                          \
+    } while (false)
+
+#define LOG_TRACE(aLog, ...) LOG_AT(aLog, LogLevel::Trace, __VA_ARGS__)
+#define LOG_DEBUG(aLog, ...) LOG_AT(aLog, LogLevel::Debug, __VA_ARGS__)
+#define LOG_INFO(aLog, ...)  LOG_AT(aLog, LogLevel::Info, __VA_ARGS__)
+#define LOG_WARN(aLog, ...)  LOG_AT(aLog, LogLevel::Warn, __VA_ARGS__)
+#define LOG_ERROR(aLog, ...) LOG_AT(aLog, LogLevel::Error, __VA_ARGS__)
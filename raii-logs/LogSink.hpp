@@ -0,0 +1,80 @@
+#pragma once
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <fstream>
+#include <ios>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+// Where a LogWriter's bytes end up. Used by one thread at a time: the logging thread in sync
+// mode, the writer thread in async mode.
+class LogSink {
+  public:
+    virtual ~LogSink() = default;
+
+    // Appends aBytes to the log
+    virtual void Write(std::span<const char> aBytes) = 0;
+
+    // Hands anything still buffered in the process to the OS
+    virtual void Flush() {}
+
+    // Makes everything written so far durable: flushed, and on the storage device (fdatasync)
+    virtual void Sync() = 0;
+};
+
+// Through a std::fstream opened for appending, with its own buffer. A std::fstream has no file
+// descriptor to sync, so the file is also opened read-only for that: fdatasync() syncs the file,
+// whichever descriptor it's called on.
+class StreamSink final : public LogSink {
+  public:
+    explicit StreamSink(const std::string& aFileName) {
+        mFileStream.open(aFileName, std::ios::out | std::ios::app | std::ios::binary);
+        if (!mFileStream.is_open()) {
+            throw std::runtime_error("Failed to open file: " + aFileName);
+        }
+        mSyncFd = open(aFileName.c_str(), O_RDONLY | O_CLOEXEC);
+        if (mSyncFd < 0)
+            throw std::system_error(errno, std::generic_category(), "open " + aFileName);
+    }
+
+    ~StreamSink() override { close(mSyncFd); }
+
+    StreamSink(const StreamSink&)            = delete;
+    StreamSink& operator=(const StreamSink&) = delete;
+
+    void Write(std::span<const char> aBytes) override {
+        errno = 0;
+        mFileStream.write(aBytes.data(), static_cast<std::streamsize>(aBytes.size()));
+        Check_Stream("write");
+    }
+
+    void Flush() override {
+        errno = 0;
+        mFileStream.flush();
+        Check_Stream("flush");
+    }
+
+    void Sync() override {
+        Flush();
+        if (fdatasync(mSyncFd) != 0)
+            throw std::system_error(errno, std::generic_category(), "fdatasync");
+    }
+
+  private:
+    // A failed write (ENOSPC, EIO) only sets the stream's badbit: without this, Sync() would
+    // report bytes that never reached the file as durable. errno is the failed write()'s.
+    void Check_Stream(const char* aOperation) {
+        if (mFileStream.fail()) {
+            auto cError = (errno != 0) ? errno : EIO;
+            throw std::system_error(cError, std::generic_category(), aOperation);
+        }
+    }
+
+    std::fstream mFileStream;
+    int          mSyncFd = -1;
+};
@@ -0,0 +1,272 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <span>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "LogSink.hpp"
+#include "MappedSink.hpp"
+#include "PmrAllocator.hpp"
+#include "RotatingSink.hpp"
+#include "SPSC.hpp"
+#include "UringSink.hpp"
+
+// Where records are written to the file: on the logging thread (Sync), or by a background writer
+// thread (Async). Async log calls copy the formatted record into a lock-free ring and return: they
+// only wait if the ring is full. The writer pops whatever has accumulated and writes it in one go.
+enum class LogMode { Sync, Async };
+
+// When a record reaches the disk. Buffered: when the stream's buffer fills, or the async writer
+// catches up. Flush: handed to the OS after every write, so it survives the process crashing.
+// Sync: on the storage device (fdatasync) before the log call returns. Group: the async writer
+// syncs every GroupCommit::records records or GroupCommit::interval, whichever comes first, and
+// log calls don't wait: Wait_Durable() does. Group needs the writer thread, so it implies Async.
+enum class LogDurability { Buffered, Flush, Sync, Group };
+
+struct GroupCommit {
+    std::size_t               records = 256;  // About: counted as records are queued
+    std::chrono::milliseconds interval{2};    // After the first record not yet synced
+};
+
+// How the file is written: through a std::fstream (StreamSink), by copying into a memory-mapped
+// window of it (MappedSink), or by batched writes submitted through io_uring (UringSink)
+enum class SinkType { Stream, Mapped, Uring };
+
+inline std::unique_ptr<LogSink> Open_Sink(SinkType aType, const std::string& aFileName) {
+    if (aType == SinkType::Mapped)
+        return std::make_unique<MappedSink>(aFileName);
+    if (aType == SinkType::Uring)
+        return std::make_unique<UringSink>(aFileName);
+    return std::make_unique<StreamSink>(aFileName);
+}
+
+// A sink that rotates between files of aType, if aRotation is enabled
+inline std::unique_ptr<LogSink> Open_Sink(SinkType aType, const std::string& aFileName,
+                                          const Rotation& aRotation) {
+    if (!aRotation.Is_Enabled())
+        return Open_Sink(aType, aFileName);
+    return std::make_unique<RotatingSink>(aFileName, aRotation, [aType](const auto& aName) {
+        return Open_Sink(aType, aName);
+    });
+}
+
+// Appends a log's records to its sink, in either mode. On destruction, an async writer drains the
+// ring before it is joined, so nothing is lost.
+//
+// Durability in async mode: the writer counts the bytes it has written and publishes how many of
+// them are synced, so a waiting logging thread (Sync, Wait_Durable()) knows when its bytes are on
+// disk. One fdatasync() acknowledges every byte written before it.
+//
+// Errors in async mode: if the sink throws on the writer thread, the writer keeps the exception,
+// wakes any waiting thread and from then on discards records (so logging never blocks on a full
+// ring). Wait_Durable() and Close() rethrow it; the destructor can't.
+class LogWriter {
+  public:
+    LogWriter(std::unique_ptr<LogSink> aSink, LogMode aMode, int aQueueBytes,
+              LogDurability aDurability = LogDurability::Buffered, const GroupCommit& aGroup = {})
+        : mSink(std::move(aSink)),
+          mMode((aDurability == LogDurability::Group) ? LogMode::Async : aMode),
+          mDurability(aDurability), mGroup(aGroup) {
+        if (mMode == LogMode::Async) {
+            mQueue.Allocate(mAllocator, aQueueBytes);
+            mWriter = std::thread(&LogWriter::Run_Writer, this);
+        }
+    }
+
+    // Best effort: destructors can't throw
+    ~LogWriter() {
+        try {
+            Close();
+        } catch (const std::exception&) {
+        }
+    }
+
+    LogWriter(const LogWriter&)            = delete;
+    LogWriter& operator=(const LogWriter&) = delete;
+
+    // Not thread-safe: one logging thread at a time (the async ring has a single producer)
+    void Write(std::span<const char> aRecord) {
+        if (mMode == LogMode::Sync) {
+            mSink->Write(aRecord);
+            if (mDurability == LogDurability::Flush)
+                mSink->Flush();
+            else if (mDurability == LogDurability::Sync)
+                mSink->Sync();
+            return;
+        }
+
+        mQueue.Emplace_Multiple_Await(aRecord);
+        mQueuedBytes += aRecord.size();
+        mNumQueued.fetch_add(1, std::memory_order::relaxed);
+        if (mDurability == LogDurability::Sync)
+            Wait_Durable();
+    }
+
+    // Waits until everything written so far is on the storage device. From the logging thread.
+    // In async mode with Buffered or Flush durability, the writer doesn't sync: this waits until
+    // it has written everything, then syncs (the writer won't touch the sink again until this
+    // thread logs more).
+    void Wait_Durable() {
+        if (mMode == LogMode::Sync) {
+            mSink->Sync();
+            return;
+        }
+        if ((mDurability == LogDurability::Sync) || (mDurability == LogDurability::Group)) {
+            Wait_For(mDurableBytes);
+            return;
+        }
+        Wait_For(mWrittenBytes);
+        mSink->Sync();
+    }
+
+    // Drains the async ring, joins the writer and flushes. Rethrows the writer's error, if it
+    // failed. Nothing can be written after.
+    void Close() {
+        if (mIsClosed)
+            return;
+        mIsClosed = true;
+        if (mMode == LogMode::Async) {
+            mQueue.End_PopWaiting();
+            mWriter.join();
+            mQueue.Free(mAllocator);
+            if (mError)
+                std::rethrow_exception(mError);
+        }
+        mSink->Flush();
+    }
+
+    LogMode       mode() const { return mMode; }
+    LogDurability durability() const { return mDurability; }
+    bool          is_closed() const { return mIsClosed; }
+
+  private:
+    static constexpr std::size_t sMaxWriteBytes = 64 * 1024;  // Per write by the async writer
+    static constexpr auto        sFailed        = std::numeric_limits<std::uint64_t>::max();
+
+    // Waits until aBytes (written or durable) covers everything queued, or the writer failed
+    void Wait_For(const std::atomic<std::uint64_t>& aBytes) const {
+        auto cBytes = aBytes.load(std::memory_order::acquire);
+        while (cBytes < mQueuedBytes) {
+            aBytes.wait(cBytes, std::memory_order::acquire);
+            cBytes = aBytes.load(std::memory_order::acquire);
+        }
+        if (cBytes == sFailed)
+            std::rethrow_exception(mError);
+    }
+
+    // Async: writes batches of records until the ring is ended and drained
+    void Run_Writer() {
+        try {
+            Write_Batches();
+        } catch (...) {
+            // Published by storing sFailed, which also wakes waiting threads
+            mError = std::current_exception();
+            mWrittenBytes.store(sFailed, std::memory_order::release);
+            mWrittenBytes.notify_all();
+            mDurableBytes.store(sFailed, std::memory_order::release);
+            mDurableBytes.notify_all();
+
+            std::vector<char> cDiscarded;
+            cDiscarded.reserve(sMaxWriteBytes);  // Pops fill the capacity
+            do {
+                cDiscarded.clear();
+                mQueue.Pop_Multiple_Await(cDiscarded);
+            } while (!cDiscarded.empty());
+        }
+    }
+
+    void Write_Batches() {
+        std::vector<char>                     cBatch;
+        std::uint64_t                         cNumSynced = 0;  // Records queued as of the last sync
+        std::chrono::steady_clock::time_point cSyncDue;        // Group: by the interval
+        cBatch.reserve(sMaxWriteBytes);
+        while (true) {
+            cBatch.clear();
+            bool cIsUnsynced = (mDurability == LogDurability::Group) &&
+                               (mWrittenBytes.load(std::memory_order::relaxed) >
+                                mDurableBytes.load(std::memory_order::relaxed));
+            if (cIsUnsynced) {
+                // Group: don't wait past the interval for more records
+                mQueue.Pop_Multiple(cBatch);
+                if (cBatch.empty()) {
+                    std::this_thread::sleep_until(cSyncDue);
+                    cNumSynced = Sync_Written();
+                    continue;
+                }
+            } else {
+                mQueue.Pop_Multiple_Await(cBatch);
+                if (cBatch.empty())
+                    break;  // Ended, and nothing left
+            }
+
+            mSink->Write(cBatch);
+            switch (mDurability) {
+                case LogDurability::Buffered:
+                    if (mQueue.empty())
+                        mSink->Flush();  // Caught up: hand what we have to the OS
+                    break;
+                case LogDurability::Flush:
+                    mSink->Flush();
+                    break;
+                case LogDurability::Sync:
+                case LogDurability::Group:
+                    break;
+            }
+
+            // After the sink calls: a thread waiting for these bytes may then use the sink
+            auto cWrittenBytes = mWrittenBytes.load(std::memory_order::relaxed) + cBatch.size();
+            mWrittenBytes.store(cWrittenBytes, std::memory_order::release);
+            if ((mDurability == LogDurability::Buffered) || (mDurability == LogDurability::Flush))
+                mWrittenBytes.notify_all();
+
+            if (mDurability == LogDurability::Sync) {
+                Sync_Written();  // Everything written: the logging thread is waiting
+            } else if (mDurability == LogDurability::Group) {
+                auto cNow = std::chrono::steady_clock::now();
+                if (!cIsUnsynced)
+                    cSyncDue = cNow + mGroup.interval;
+                auto cNumQueued = mNumQueued.load(std::memory_order::relaxed);
+                if ((cNumQueued - cNumSynced >= mGroup.records) || (cNow >= cSyncDue))
+                    cNumSynced = Sync_Written();
+            }
+        }
+    }
+
+    // Syncs, and wakes the logging thread if it waits for the bytes written so far. Returns the
+    // number of records queued before the sync (at least those now on disk).
+    std::uint64_t Sync_Written() {
+        auto cNumQueued = mNumQueued.load(std::memory_order::relaxed);
+        mSink->Sync();
+        mDurableBytes.store(mWrittenBytes.load(std::memory_order::relaxed),
+                            std::memory_order::release);
+        mDurableBytes.notify_all();
+        return cNumQueued;
+    }
+
+    std::unique_ptr<LogSink> mSink;
+    LogMode                  mMode;
+    bool                     mIsClosed = false;
+
+    LogDurability            mDurability;
+    GroupCommit              mGroup;
+
+    // Async only
+    PmrAllocator                      mAllocator;
+    SPSC<char, WaitPolicy::BothAwait> mQueue;
+    std::thread                       mWriter;
+    std::uint64_t                     mQueuedBytes = 0;  // Logging thread only
+    std::atomic<std::uint64_t>        mNumQueued{0};     // Records
+    std::atomic<std::uint64_t>        mWrittenBytes{0};  // By the writer (sFailed: it failed)
+    std::atomic<std::uint64_t>        mDurableBytes{0};  // Synced by the writer (sFailed: ditto)
+    std::exception_ptr                mError;            // Published with sFailed
+};
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <span>
+#include <string>
+#include <system_error>
+
+#include "LogSink.hpp"
+
+// Appends into a memory-mapped window of the file, so a write is a memcpy into the page cache and
+// the kernel writes the pages back: no write() per batch, and no stream buffer or locale. When a
+// write doesn't fit, the file is grown by a large chunk (ftruncate()) and the window remapped
+// there. On destruction the file is truncated to the bytes actually written.
+//
+// Until then, and after a crash, the file ends in up to a chunk of zero bytes: text readers see
+// NULs after the last record. Reopening appends after them.
+class MappedSink final : public LogSink {
+  public:
+    static constexpr std::size_t sDefaultChunkBytes = 64 * 1024 * 1024;
+
+    explicit MappedSink(const std::string& aFileName, std::size_t aChunkBytes = sDefaultChunkBytes)
+        : mChunkBytes(Round_Up(aChunkBytes, Page_Size())) {
+        mFd = open(aFileName.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (mFd < 0)
+            throw std::system_error(errno, std::generic_category(), "open " + aFileName);
+
+        struct stat cStat;
+        if (fstat(mFd, &cStat) != 0) {
+            auto cError = errno;
+            close(mFd);
+            throw std::system_error(cError, std::generic_category(), "fstat");
+        }
+        mLength = static_cast<std::size_t>(cStat.st_size);
+    }
+
+    // Best effort: destructors can't throw
+    ~MappedSink() override {
+        Unmap();
+        [[maybe_unused]] auto cResult = ftruncate(mFd, static_cast<off_t>(mLength));
+        close(mFd);
+    }
+
+    MappedSink(const MappedSink&)            = delete;
+    MappedSink& operator=(const MappedSink&) = delete;
+
+    void Write(std::span<const char> aBytes) override {
+        if (mLength + aBytes.size() > mMapOffset + mMapBytes)
+            Remap(aBytes.size());
+        std::memcpy(mMapping + (mLength - mMapOffset), aBytes.data(), aBytes.size());
+        mLength += aBytes.size();
+    }
+
+    // The window's pages (msync()), then the file's size, and pages of earlier windows
+    // (fdatasync())
+    void Sync() override {
+        if ((mMapping != nullptr) && (mLength > mMapOffset) &&
+            (msync(mMapping, mLength - mMapOffset, MS_SYNC) != 0))
+            throw std::system_error(errno, std::generic_category(), "msync");
+        if (fdatasync(mFd) != 0)
+            throw std::system_error(errno, std::generic_category(), "fdatasync");
+    }
+
+    std::size_t size() const { return mLength; }
+
+  private:
+    static std::size_t Page_Size() { return static_cast<std::size_t>(sysconf(_SC_PAGESIZE)); }
+
+    static std::size_t Round_Up(std::size_t aSize, std::size_t aMultiple) {
+        return ((aSize + aMultiple - 1) / aMultiple) * aMultiple;
+    }
+
+    // Maps a window from the page holding the end of the log, with room for aNumBytes more
+    void Remap(std::size_t aNumBytes) {
+        Unmap();
+        mMapOffset = (mLength / Page_Size()) * Page_Size();
+        mMapBytes  = Round_Up(mLength - mMapOffset + aNumBytes, mChunkBytes);
+
+        // Writing to pages past the end of the file is a SIGBUS: grow it first
+        if (ftruncate(mFd, static_cast<off_t>(mMapOffset + mMapBytes)) != 0)
+            throw std::system_error(errno, std::generic_category(), "ftruncate");
+        auto cAddress = mmap(nullptr, mMapBytes, PROT_READ | PROT_WRITE, MAP_SHARED, mFd,
+                             static_cast<off_t>(mMapOffset));
+        if (cAddress == MAP_FAILED) {
+            mMapBytes = 0;
+            throw std::system_error(errno, std::generic_category(), "mmap");
+        }
+        mMapping = static_cast<char*>(cAddress);
+    }
+
+    void Unmap() {
+        if (mMapping != nullptr)
+            munmap(mMapping, mMapBytes);
+        mMapping  = nullptr;
+        mMapBytes = 0;
+    }
+
+    int         mFd         = -1;
+    std::size_t mChunkBytes = 0;
+    std::size_t mLength     = 0;  // Of the log: where the next write goes
+    std::size_t mMapOffset  = 0;  // File offset of the window
+    std::size_t mMapBytes   = 0;  // Size of the window
+    char*       mMapping    = nullptr;
+};
@@ -0,0 +1,459 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "LogFile.hpp"
+
+// A text log many threads can write to at once. Each logging thread formats its records into its
+// own lock-free ring (an SPSC of bytes, registered on its first record: the only time it takes a
+// lock), and a collector thread merges the rings into the file in timestamp order.
+//
+//   MergedLogFile log("app.log");
+//   std::jthread cWorker([&] { log << "From a worker"; });
+//   log << "From main";
+//
+// A record can only be written once no thread can still log an earlier one. Each thread raises a
+// flag around a log call, before reading the clock: the collector reads the clock, then the flags,
+// so a thread that wasn't logging then will only log later times. A thread that was is held to its
+// latest record the collector has seen. Records usually reach the file within a couple of
+// milliseconds (the collector's polling interval).
+//
+// LogOptions::mode is ignored (the collector always writes), and queue_bytes sizes each thread's
+// ring. A thread's ring lives until the log is closed, even if the thread exits first.
+//
+// Durability is the collector's: with Sync, a log call waits until the collector has synced its
+// record, and one sync acknowledges every thread waiting by then. With Group, it syncs every
+// GroupCommit::records records or GroupCommit::interval, and Wait_Durable() waits for the calling
+// thread's records. Buffered and Flush are the same here: the collector flushes every batch, and
+// syncs only while a thread waits in Wait_Durable().
+class MergedLogFile {
+  public:
+    MergedLogFile(const std::string& aName, const LogOptions& aOptions = {})
+        : mSink(Open_Sink(aOptions.sink, aName, aOptions.rotation)),
+          mQueueBytes(aOptions.queue_bytes), mPrecision(aOptions.precision),
+          mThreshold(aOptions.level), mDurability(aOptions.durability), mGroup(aOptions.group),
+          mId(sNextId.fetch_add(1, std::memory_order::relaxed)) {
+        mCollector = std::thread(&MergedLogFile::Run_Collector, this);
+        try {
+            this->operator<<("LOG OPENED");  // With Sync, rethrows the collector's error
+        } catch (...) {
+            Stop_Collector();
+            throw;
+        }
+    }
+
+    // Best effort: destructors can't throw
+    ~MergedLogFile() {
+        try {
+            Close();
+        } catch (const std::exception&) {
+        }
+    }
+
+    MergedLogFile(const MergedLogFile&)            = delete;
+    MergedLogFile& operator=(const MergedLogFile&) = delete;
+
+    // Thread-safe, and lock-free after a thread's first record
+    void operator<<(std::string_view aData) {
+        Log_Record({}, [aData](std::string& aRecord) { aRecord.append(aData); });
+    }
+
+    // "[...] INFO  <data>", if aLevel is enabled. See LOG_AT, which skips building aData too.
+    void Log(LogLevel aLevel, std::string_view aData) {
+        if (Is_Enabled(aLevel))
+            Log_Record(Level_Tag(aLevel), [aData](std::string& aRecord) { aRecord.append(aData); });
+    }
+
+    // aFormat with its placeholders filled in, formatted straight into the calling thread's
+    // record buffer (Format_To): no allocation once it has grown
+    template <typename... ArgumentTypes>
+        requires(sizeof...(ArgumentTypes) > 0)
+    void Log(LogLevel aLevel, std::string_view aFormat, const ArgumentTypes&... aArguments) {
+        if (Is_Enabled(aLevel)) {
+            Log_Record(Level_Tag(aLevel), [&](std::string& aRecord) {
+                Format_To(aRecord, aFormat, aArguments...);
+            });
+        }
+    }
+
+    bool Is_Enabled(LogLevel aLevel) const { return mThreshold.Is_Enabled(aLevel); }
+
+    // Waits until the calling thread's records so far are on disk (with Buffered or Flush
+    // durability, the collector syncs once it has written them). Rethrows the collector's error.
+    void Wait_Durable() {
+        auto& cBuffer = This_Thread_Buffer();
+        mNumSyncWaiters.fetch_add(1, std::memory_order::relaxed);
+        auto cDurable = cBuffer.num_durable.load(std::memory_order::acquire);
+        while ((cDurable < cBuffer.num_logged) && !mHasFailed.load(std::memory_order::acquire)) {
+            cBuffer.num_durable.wait(cDurable, std::memory_order::acquire);
+            cDurable = cBuffer.num_durable.load(std::memory_order::acquire);
+        }
+        mNumSyncWaiters.fetch_sub(1, std::memory_order::relaxed);
+        if (mHasFailed.load(std::memory_order::acquire))
+            std::rethrow_exception(mError);
+    }
+
+    // Other threads must have stopped logging. The collector then drains every ring, so
+    // LOG CLOSED is still the last record. Rethrows the collector's error, if it failed (see
+    // Run_Collector()), which the destructor (closing it if this wasn't called) can't.
+    void Close() {
+        if (mIsClosed)
+            return;
+        try {
+            this->operator<<("LOG CLOSED");
+        } catch (...) {
+            Stop_Collector();
+            throw;
+        }
+        Stop_Collector();
+        if (mError)
+            std::rethrow_exception(mError);
+    }
+
+    void     Set_Level(LogLevel aLevel) { mThreshold.Set(aLevel); }
+    LogLevel level() const { return mThreshold.Get(); }
+
+    // Logging threads so far
+    std::size_t num_threads() const {
+        std::lock_guard cLock(mMutex);
+        return mBuffers.size();
+    }
+
+  private:
+    static constexpr std::size_t sHeaderSize    = sizeof(std::int64_t) + sizeof(std::uint32_t);
+    static constexpr std::size_t sMaxWriteBytes = 64 * 1024;  // Per write by the collector
+    static constexpr auto        sPollInterval  = std::chrono::milliseconds(1);
+    static constexpr auto        sFailed        = std::numeric_limits<std::uint64_t>::max();
+
+    void Stop_Collector() {
+        mIsClosed = true;
+        mIsClosing.store(true, std::memory_order::release);
+        mCollector.join();
+        for (auto& cBuffer : mBuffers)
+            cBuffer->queue.Free(mAllocator);
+    }
+
+    // aAppendMessage(record) appends the message to the record
+    template <typename AppendType>
+    void Log_Record(std::string_view aTag, const AppendType& aAppendMessage) {
+        auto& cBuffer = This_Thread_Buffer();
+        cBuffer.is_logging.store(true, std::memory_order::relaxed);
+        std::atomic_thread_fence(std::memory_order::seq_cst);  // Pairs with the collector's
+
+        auto         cNow        = Read_Clock(mPrecision);
+        std::int64_t cNanosecond = std::int64_t{cNow.tv_sec} * 1'000'000'000 + cNow.tv_nsec;
+
+        // "<nanoseconds><text size><text>": the collector only needs the header to merge
+        auto& cRecord = cBuffer.record;
+        cRecord.resize(sHeaderSize);
+        try {
+            cRecord.append(cBuffer.timestamps.Prefix(cNow));
+            cRecord.append(aTag);
+            auto cMessageStart = cRecord.size();
+            aAppendMessage(cRecord);
+            End_Record(cRecord, cMessageStart);
+        } catch (...) {
+            // No record (bad_alloc, say): the collector mustn't keep waiting for it
+            cBuffer.is_logging.store(false, std::memory_order::release);
+            throw;
+        }
+
+        auto cTextSize = static_cast<std::uint32_t>(cRecord.size() - sHeaderSize);
+        std::memcpy(cRecord.data(), &cNanosecond, sizeof(cNanosecond));
+        std::memcpy(cRecord.data() + sizeof(cNanosecond), &cTextSize, sizeof(cTextSize));
+        cBuffer.queue.Emplace_Multiple_Await(std::span<const char>(cRecord));
+        ++cBuffer.num_logged;
+
+        cBuffer.is_logging.store(false, std::memory_order::release);
+        if (mDurability == LogDurability::Sync)
+            Wait_Durable();
+    }
+
+    struct ThreadBuffer {
+        explicit ThreadBuffer(TimestampPrecision aPrecision) : timestamps(aPrecision) {}
+
+        SPSC<char, WaitPolicy::PushAwait> queue;
+        std::atomic<bool>                 is_logging{false};  // Within a log call
+        std::atomic<std::uint64_t>        num_durable{0};     // Records synced by the collector
+
+        // Logging thread only
+        TimestampCache timestamps;
+        std::string    record;  // Reused: no allocation once grown
+        std::uint64_t  num_logged = 0;
+
+        // Collector only: popped bytes, from the first record not yet written
+        std::vector<char> pending;
+        std::size_t       next           = 0;  // Offset of that record
+        std::size_t       complete_end   = 0;  // Offset past the last complete record
+        std::int64_t      last_popped_ns = 0;  // Timestamp of that record
+        std::uint64_t     num_written    = 0;
+    };
+
+    // A thread's buffer for a log, by log id (ids aren't reused, so entries of closed logs are
+    // never matched). Once the log is closed, the buffer is gone: the entry is dropped.
+    struct ThreadEntry {
+        std::uint64_t       id;
+        std::weak_ptr<bool> lifetime;  // Of the log
+        ThreadBuffer*       buffer;
+    };
+
+    // The calling thread's buffer for this log, registered on its first record
+    ThreadBuffer& This_Thread_Buffer() {
+        thread_local std::vector<ThreadEntry> tBuffers;
+        for (const auto& cEntry : tBuffers) {
+            if (cEntry.id == mId)
+                return *cEntry.buffer;
+        }
+
+        // Registering: drop the entries of closed logs, so logs created and closed over and
+        // over don't grow the vector
+        std::erase_if(tBuffers,
+                      [](const ThreadEntry& aEntry) { return aEntry.lifetime.expired(); });
+
+        auto cBuffer = std::make_unique<ThreadBuffer>(mPrecision);
+        std::lock_guard cLock(mMutex);
+        cBuffer->queue.Allocate(mAllocator, mQueueBytes);
+        tBuffers.push_back({mId, mLifetime, cBuffer.get()});
+        return *mBuffers.emplace_back(std::move(cBuffer));
+    }
+
+    // Collector thread. If the sink throws, the error is kept for Wait_Durable() and Close(),
+    // waiting threads are woken, and from then on records are discarded (so logging threads
+    // never block on a full ring).
+    void Run_Collector() {
+        try {
+            Collect();
+        } catch (...) {
+            mError = std::current_exception();
+            mHasFailed.store(true, std::memory_order::release);
+            std::lock_guard cLock(mMutex);
+            for (auto& cBuffer : mBuffers) {
+                cBuffer->num_durable.store(sFailed, std::memory_order::release);
+                cBuffer->num_durable.notify_all();
+            }
+        }
+        if (mHasFailed.load(std::memory_order::relaxed))
+            Discard_Until_Closed();
+    }
+
+    void Discard_Until_Closed() {
+        std::vector<char> cDiscarded;
+        cDiscarded.reserve(sMaxWriteBytes);  // Pops fill the capacity
+        while (true) {
+            auto cIsClosing = mIsClosing.load(std::memory_order::acquire);
+            {
+                std::lock_guard cLock(mMutex);
+                for (auto& cBuffer : mBuffers) {
+                    do {
+                        cDiscarded.clear();
+                        cBuffer->queue.Pop_Multiple(cDiscarded);
+                    } while (!cDiscarded.empty());
+                }
+            }
+            if (cIsClosing)
+                return;
+            std::this_thread::sleep_for(sPollInterval);
+        }
+    }
+
+    // Merges what the rings hold into the file, until the log is closed
+    void Collect() {
+        std::vector<ThreadBuffer*>            cBuffers;
+        std::vector<bool>                     cWasLogging;
+        std::vector<char>                     cBatch;
+        std::size_t                           cNumUnsynced = 0;  // Written since the last sync
+        std::chrono::steady_clock::time_point cSyncDue;          // Group: by the interval
+        cBatch.reserve(sMaxWriteBytes);
+        while (true) {
+            // After the last record: nothing else will be logged
+            auto cIsClosing = mIsClosing.load(std::memory_order::acquire);
+
+            auto cNow    = Read_Clock(mPrecision);
+            auto cCutoff = std::int64_t{cNow.tv_sec} * 1'000'000'000 + cNow.tv_nsec;
+            {
+                std::lock_guard cLock(mMutex);
+                cBuffers.clear();
+                for (auto& cBuffer : mBuffers)
+                    cBuffers.push_back(cBuffer.get());
+            }
+
+            // The clock, then the flags: a thread not logging yet will read a later time. Flags
+            // before popping: a record popped now may be the one being logged.
+            std::atomic_thread_fence(std::memory_order::seq_cst);
+            cWasLogging.resize(cBuffers.size());
+            for (std::size_t cIndex = 0; cIndex < cBuffers.size(); ++cIndex)
+                cWasLogging[cIndex] = cBuffers[cIndex]->is_logging.load(std::memory_order::acquire);
+
+            bool cPoppedAny = false;
+            for (std::size_t cIndex = 0; cIndex < cBuffers.size(); ++cIndex) {
+                cPoppedAny |= Pop_Pending(*cBuffers[cIndex]);
+                if (cWasLogging[cIndex])
+                    cCutoff = std::min(cCutoff, cBuffers[cIndex]->last_popped_ns);
+            }
+            if (cIsClosing)
+                cCutoff = std::numeric_limits<std::int64_t>::max();
+
+            auto cNumWritten = Merge(cBuffers, cCutoff, cBatch);
+            bool cIsGroup    = (mDurability == LogDurability::Group);
+            if ((mDurability == LogDurability::Buffered) || (mDurability == LogDurability::Flush)) {
+                if (cNumWritten > 0)
+                    mSink->Flush();
+            }
+
+            // Sync: every record. Group: by count or interval. Else only for Wait_Durable().
+            auto cSteadyNow = std::chrono::steady_clock::now();
+            if ((cNumUnsynced == 0) && (cNumWritten > 0))
+                cSyncDue = cSteadyNow + mGroup.interval;
+            cNumUnsynced += cNumWritten;
+            bool cIsGroupDue = cIsGroup && ((cNumUnsynced >= mGroup.records) ||
+                                            (cSteadyNow >= cSyncDue) || cIsClosing);
+            bool cIsSyncDue = (mDurability == LogDurability::Sync) || cIsGroupDue ||
+                              (mNumSyncWaiters.load(std::memory_order::relaxed) > 0);
+            if ((cNumUnsynced > 0) && cIsSyncDue) {
+                Sync_Written(cBuffers);
+                cNumUnsynced = 0;
+            }
+            if (cIsClosing)
+                break;
+            if (!cPoppedAny) {
+                auto cWakeUp = std::chrono::steady_clock::now() + sPollInterval;
+                std::this_thread::sleep_until((cIsGroup && (cNumUnsynced > 0))
+                                                  ? std::min(cWakeUp, cSyncDue)
+                                                  : cWakeUp);
+            }
+        }
+    }
+
+    // Syncs, and wakes the threads waiting for the records written so far
+    void Sync_Written(std::span<ThreadBuffer* const> aBuffers) {
+        mSink->Sync();
+        for (auto cBuffer : aBuffers) {
+            if (cBuffer->num_durable.load(std::memory_order::relaxed) == cBuffer->num_written)
+                continue;
+            cBuffer->num_durable.store(cBuffer->num_written, std::memory_order::release);
+            cBuffer->num_durable.notify_all();
+        }
+    }
+
+    // Pops whatever aBuffer's ring holds. Returns whether there was anything.
+    static bool Pop_Pending(ThreadBuffer& aBuffer) {
+        auto cSize = aBuffer.queue.size();
+        if (cSize == 0)
+            return false;
+
+        // Drop what has been written
+        auto& cPending = aBuffer.pending;
+        if (aBuffer.next > 0) {
+            cPending.erase(cPending.begin(), cPending.begin() + aBuffer.next);
+            aBuffer.complete_end -= aBuffer.next;
+            aBuffer.next = 0;
+        }
+        cPending.reserve(cPending.size() + cSize);
+        aBuffer.queue.Pop_Multiple(cPending);
+
+        while (true) {
+            auto cRecord = Complete_Record(cPending, aBuffer.complete_end);
+            if (cRecord.empty())
+                break;
+            std::memcpy(&aBuffer.last_popped_ns, cRecord.data(), sizeof(std::int64_t));
+            aBuffer.complete_end += cRecord.size();
+        }
+        return true;
+    }
+
+    // Writes the popped records timestamped up to aCutoff, earliest first. Returns how many.
+    std::size_t Merge(std::span<ThreadBuffer* const> aBuffers, std::int64_t aCutoff,
+                      std::vector<char>& aBatch) {
+        std::size_t cNumWritten = 0;
+        while (true) {
+            // The earliest next record (ties go to the earlier registered thread)
+            ThreadBuffer*   cEarliest   = nullptr;
+            std::int64_t    cEarliestNs = 0;
+            std::span<char> cEarliestRecord;
+            for (auto cBuffer : aBuffers) {
+                auto cRecord = Complete_Record(cBuffer->pending, cBuffer->next);
+                if (cRecord.empty())
+                    continue;
+                std::int64_t cNanosecond;
+                std::memcpy(&cNanosecond, cRecord.data(), sizeof(cNanosecond));
+                if ((cNanosecond <= aCutoff) &&
+                    ((cEarliest == nullptr) || (cNanosecond < cEarliestNs))) {
+                    cEarliest       = cBuffer;
+                    cEarliestNs     = cNanosecond;
+                    cEarliestRecord = cRecord;
+                }
+            }
+            if (cEarliest == nullptr)
+                break;
+
+            auto cText = cEarliestRecord.subspan(sHeaderSize);
+            if (aBatch.size() + cText.size() > sMaxWriteBytes)
+                Write_Batch(aBatch);
+            aBatch.insert(aBatch.end(), cText.begin(), cText.end());
+            cEarliest->next += cEarliestRecord.size();
+            ++cEarliest->num_written;
+            ++cNumWritten;
+        }
+        Write_Batch(aBatch);
+        return cNumWritten;
+    }
+
+    void Write_Batch(std::vector<char>& aBatch) {
+        if (aBatch.empty())
+            return;
+        mSink->Write(aBatch);
+        aBatch.clear();
+    }
+
+    // The record (header and text) at aOffset of aPending, or empty if it isn't all there yet
+    static std::span<char> Complete_Record(std::vector<char>& aPending, std::size_t aOffset) {
+        auto cAvailable = aPending.size() - aOffset;
+        if (cAvailable < sHeaderSize)
+            return {};
+        std::uint32_t cTextSize;
+        std::memcpy(&cTextSize, aPending.data() + aOffset + sizeof(std::int64_t),
+                    sizeof(cTextSize));
+        if (cAvailable < sHeaderSize + cTextSize)
+            return {};
+        return std::span<char>(aPending.data() + aOffset, sHeaderSize + cTextSize);
+    }
+
+    static inline std::atomic<std::uint64_t> sNextId{0};
+
+    std::unique_ptr<LogSink> mSink;  // Collector only
+    int                      mQueueBytes;
+    TimestampPrecision       mPrecision;
+    LevelThreshold           mThreshold;
+    LogDurability            mDurability;
+    GroupCommit              mGroup;
+    std::uint64_t            mId;
+    std::shared_ptr<bool>    mLifetime = std::make_shared<bool>();  // Expires when closed
+
+    // Registered thread buffers: appended by logging threads, read by the collector
+    mutable std::mutex                         mMutex;
+    PmrAllocator                               mAllocator;
+    std::vector<std::unique_ptr<ThreadBuffer>> mBuffers;
+
+    std::atomic<bool>  mIsClosing{false};
+    std::atomic<int>   mNumSyncWaiters{0};  // In Wait_Durable(): the collector syncs
+    std::atomic<bool>  mHasFailed{false};   // The collector's sink threw mError
+    std::exception_ptr mError;              // Published by mHasFailed
+    bool               mIsClosed = false;   // Owner only
+    std::thread        mCollector;
+};
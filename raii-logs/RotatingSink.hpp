@@ -0,0 +1,246 @@
+#pragma once
+
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <ctime>
+#include <functional>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+
+#include "LogSink.hpp"
+#include "PmrAllocator.hpp"
+#include "SPSC.hpp"
+
+extern char** environ;
+
+// When to start a new file: past max_bytes, or interval after the current file was started
+// (whichever comes first; 0 disables either). Rotated files are renamed to
+// "<name>.<YYYYmmdd-HHMMSS>-<n>", n being the first that isn't taken (and gzipped, with compress).
+struct Rotation {
+    std::size_t          max_bytes = 0;
+    std::chrono::seconds interval{0};
+    bool                 compress = false;  // With gzip, if installed
+
+    bool Is_Enabled() const { return (max_bytes > 0) || (interval.count() > 0); }
+};
+
+// Rotates a text log between files without the writing thread ever opening, closing or renaming
+// one. A background thread opens the next file ahead of time ("<name>.pending"), and rotating
+// swaps the sinks: the writing thread takes the pending one (an atomic exchange) and queues the
+// old one back. The background thread then closes it, renames it out of the way, renames the
+// pending file to <name>, compresses the old one and opens the next pending file.
+//
+// Rotation happens at a record boundary (a newline), so a record is never split between files:
+// by size, after the last record that fits in max_bytes (a record larger than that gets a file of
+// its own). If the next file isn't ready yet, writing continues to the current one until it is.
+// If renaming fails, rotation stops (rotation_error()), and logging continues to the current file:
+// an older file is never overwritten.
+class RotatingSink final : public LogSink {
+  public:
+    using SinkFactory = std::function<std::unique_ptr<LogSink>(const std::string&)>;
+
+    RotatingSink(const std::string& aFileName, const Rotation& aRotation, SinkFactory aOpenSink)
+        : mFileName(aFileName), mPendingName(aFileName + ".pending"), mRotation(aRotation),
+          mOpenSink(std::move(aOpenSink)), mActive(mOpenSink(mFileName)),
+          mActiveStart(std::chrono::steady_clock::now()) {
+        mRetired.Allocate(mAllocator, sMaxRetired);
+        mRotator = std::thread(&RotatingSink::Run_Rotator, this);
+    }
+
+    // Best effort: destructors can't throw
+    ~RotatingSink() override {
+        mRetired.End_PopWaiting();
+        mRotator.join();
+        mRetired.Free(mAllocator);
+
+        // Not needed after all
+        if (auto cPending = mPending.exchange(nullptr, std::memory_order::acquire)) {
+            delete cPending;
+            std::remove(mPendingName.c_str());
+        }
+    }
+
+    RotatingSink(const RotatingSink&)            = delete;
+    RotatingSink& operator=(const RotatingSink&) = delete;
+
+    // A batch can span several files, if it's larger than max_bytes
+    void Write(std::span<const char> aBytes) override {
+        while (!aBytes.empty()) {
+            auto cSplit = Rotation_Split(aBytes);
+            if (cSplit == std::string_view::npos)
+                break;
+            Write_Active(aBytes.first(cSplit));
+            aBytes = aBytes.subspan(cSplit);
+            if (!Rotate())
+                break;
+        }
+        Write_Active(aBytes);
+    }
+
+    void Flush() override { mActive->Flush(); }
+
+    // Once synced, rotating syncs the old file before retiring it: a record that was written
+    // to it is durable by the next Sync(), even though that only syncs the new file
+    void Sync() override {
+        mActive->Sync();
+        mIsDurable = true;
+    }
+
+    std::size_t num_rotations() const { return mNumRotations; }
+
+    // The errno of the rename that stopped rotation, else 0
+    int rotation_error() const { return mRotationError.load(std::memory_order::relaxed); }
+
+  private:
+    static constexpr int sMaxRetired = 2;
+
+    // Where in aBytes to rotate: npos if it isn't due, or there's no record boundary to do it at
+    std::size_t Rotation_Split(std::span<const char> aBytes) const {
+        std::string_view cText(aBytes.data(), aBytes.size());
+        auto             cMaxBytes = mRotation.max_bytes;
+        if ((cMaxBytes > 0) && (mActiveBytes + aBytes.size() > cMaxBytes)) {
+            // After the last record that fits
+            auto cRoom = (mActiveBytes < cMaxBytes) ? cMaxBytes - mActiveBytes : 0;
+            auto cLast = (cRoom > 0) ? cText.rfind('\n', cRoom - 1) : std::string_view::npos;
+            if (cLast != std::string_view::npos)
+                return cLast + 1;
+
+            // None fits: rotate now, unless the current record must be finished first (or the
+            // file is empty, so the record gets it to itself)
+            return (mAtRecordStart && (mActiveBytes > 0)) ? 0 : Record_End(cText);
+        }
+
+        if ((mRotation.interval.count() > 0) &&
+            (std::chrono::steady_clock::now() - mActiveStart >= mRotation.interval))
+            return mAtRecordStart ? 0 : Record_End(cText);
+        return std::string_view::npos;
+    }
+
+    // Past the end of the current (or first) record, npos if it doesn't end in aText
+    static std::size_t Record_End(std::string_view aText) {
+        auto cNewline = aText.find('\n');
+        return (cNewline == std::string_view::npos) ? cNewline : cNewline + 1;
+    }
+
+    void Write_Active(std::span<const char> aBytes) {
+        if (aBytes.empty())
+            return;
+        mActive->Write(aBytes);
+        mActiveBytes += aBytes.size();
+        mAtRecordStart = (aBytes.back() == '\n');
+    }
+
+    // Swaps in the pending file if it is ready (returns whether it was), else leaves it for a
+    // later write
+    bool Rotate() {
+        auto cPending = mPending.exchange(nullptr, std::memory_order::acquire);
+        if (cPending == nullptr)
+            return false;
+
+        if (mIsDurable)
+            mActive->Sync();
+
+        // The next file is only opened once the last rotated one is retired: there's room
+        auto cRetired  = std::exchange(mActive, std::unique_ptr<LogSink>(cPending));
+        auto cIsQueued = mRetired.Emplace(std::move(cRetired));
+        Assert(cIsQueued, "Rotated files queue is full!\n");
+        mActiveBytes = 0;
+        mActiveStart = std::chrono::steady_clock::now();
+        ++mNumRotations;
+        return true;
+    }
+
+    // Background thread: retires rotated files, then prepares the next one. If a rename fails,
+    // no next one: opening <name>.pending again would reopen the active file (or, with <name>
+    // not renamed away, the next rename would overwrite it).
+    void Run_Rotator() {
+        Open_Pending();
+        std::unique_ptr<LogSink> cRetired;
+        while (mRetired.Pop_Await(cRetired)) {
+            cRetired.reset();  // Flushes and closes
+
+            auto cRotatedName = Rotated_Name();
+            if (std::rename(mFileName.c_str(), cRotatedName.c_str()) != 0) {
+                mRotationError.store(errno, std::memory_order::relaxed);
+                continue;
+            }
+            // The active file (still open)
+            if (std::rename(mPendingName.c_str(), mFileName.c_str()) != 0) {
+                mRotationError.store(errno, std::memory_order::relaxed);
+                continue;
+            }
+            if (mRotation.compress)
+                Compress(cRotatedName);
+            Open_Pending();
+        }
+    }
+
+    void Open_Pending() {
+        try {
+            mPending.store(mOpenSink(mPendingName).release(), std::memory_order::release);
+        } catch (const std::exception&) {
+            // Can't open it: no rotation, logging continues to the current file
+        }
+    }
+
+    // The first name not taken (also gzipped): the same second can come round again after a
+    // restart, or a clock change
+    std::string Rotated_Name() const {
+        auto    cNow = std::time(nullptr);
+        std::tm cTime;
+        localtime_r(&cNow, &cTime);
+
+        char cSuffix[32];
+        auto cSize   = std::strftime(cSuffix, sizeof(cSuffix), ".%Y%m%d-%H%M%S-", &cTime);
+        auto cPrefix = mFileName + std::string(cSuffix, cSize);
+        for (int cSequence = 0;; ++cSequence) {
+            auto cName = cPrefix + std::to_string(cSequence);
+            if ((access(cName.c_str(), F_OK) != 0) && (access((cName + ".gz").c_str(), F_OK) != 0))
+                return cName;
+        }
+    }
+
+    // gzip aFileName (to aFileName.gz), if gzip is installed
+    static void Compress(const std::string& aFileName) {
+        char  cCommand[]   = "gzip";
+        char  cForce[]     = "-f";
+        char* cArguments[] = {cCommand, cForce, const_cast<char*>(aFileName.c_str()), nullptr};
+
+        pid_t cProcess;
+        if (posix_spawnp(&cProcess, cCommand, nullptr, nullptr, cArguments, environ) != 0)
+            return;
+        int cStatus;
+        waitpid(cProcess, &cStatus, 0);
+    }
+
+    std::string mFileName;
+    std::string mPendingName;
+    Rotation    mRotation;
+    SinkFactory mOpenSink;
+
+    // Writing thread only
+    std::unique_ptr<LogSink>              mActive;
+    std::size_t                           mActiveBytes = 0;
+    std::chrono::steady_clock::time_point mActiveStart;
+    bool                                  mAtRecordStart = true;
+    bool                                  mIsDurable     = false;  // Synced by the writer
+    std::size_t                           mNumRotations  = 0;
+
+    // Handoffs: the next file from the background thread, rotated ones back to it
+    std::atomic<LogSink*>                                mPending{nullptr};
+    std::atomic<int>                                     mRotationError{0};
+    PmrAllocator                                         mAllocator;
+    SPSC<std::unique_ptr<LogSink>, WaitPolicy::PopAwait> mRetired;
+    std::thread                                          mRotator;
+};
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <string_view>
+
+// Digits after the seconds in a record's timestamp
+enum class TimestampPrecision { Seconds, Milliseconds, Microseconds };
+
+// Wall-clock time, from the cheapest clock good enough for aPrecision: seconds and milliseconds
+// come from the coarse clock on Linux (CLOCK_REALTIME_COARSE: the time of the last timer tick,
+// read without even a TSC read), so milliseconds advance in steps of the tick (1-4 ms).
+// Microseconds need the precise clock (CLOCK_REALTIME, still a vDSO call).
+inline timespec Read_Clock([[maybe_unused]] TimestampPrecision aPrecision) {
+    timespec cNow;
+#if defined(CLOCK_REALTIME_COARSE)
+    if (aPrecision != TimestampPrecision::Microseconds) {
+        clock_gettime(CLOCK_REALTIME_COARSE, &cNow);
+        return cNow;
+    }
+#endif
+    clock_gettime(CLOCK_REALTIME, &cNow);
+    return cNow;
+}
+
+// The "[YYYY-mm-dd HH:MM:SS] " record prefix (local time), optionally with ".mmm" or ".uuuuuu".
+// The date and time only change once a second, so they're formatted only when the second changes,
+// and otherwise reused. localtime_r() still takes glibc's timezone lock, so calling it once a
+// second rather than once a record is the saving: a call is a clock read (Read_Clock()) plus, with
+// sub-second precision, writing 3 or 6 digits.
+//
+// Not thread-safe: one per logging thread.
+class TimestampCache {
+  public:
+    explicit TimestampCache(TimestampPrecision aPrecision = TimestampPrecision::Seconds)
+        : mPrecision(aPrecision) {
+        auto cNumDigits = Num_Fraction_Digits();
+        mSize           = sDateTimeSize + (cNumDigits ? cNumDigits + 1 : 0) + 2;
+        if (cNumDigits)
+            mBuffer[sDateTimeSize] = '.';
+        mBuffer[mSize - 2] = ']';
+        mBuffer[mSize - 1] = ' ';
+    }
+
+    // The prefix for the current time. Valid until the next call.
+    std::string_view Prefix() { return Prefix(Read_Clock(mPrecision)); }
+
+    // The prefix for aTime: cheapest for times in order (e.g. decoding a binary log)
+    std::string_view Prefix(const timespec& aTime) {
+        if (aTime.tv_sec != mSecond)
+            Format_Date_Time(aTime.tv_sec);
+
+        auto cNumDigits = Num_Fraction_Digits();
+        if (cNumDigits == 3)
+            Write_Digits(sDateTimeSize + 1, aTime.tv_nsec / 1'000'000, 3);
+        else if (cNumDigits == 6)
+            Write_Digits(sDateTimeSize + 1, aTime.tv_nsec / 1'000, 6);
+        return std::string_view(mBuffer, mSize);
+    }
+
+    TimestampPrecision precision() const { return mPrecision; }
+
+  private:
+    static constexpr std::size_t sDateTimeSize = 20;  // "[YYYY-mm-dd HH:MM:SS"
+
+    int Num_Fraction_Digits() const {
+        switch (mPrecision) {
+            case TimestampPrecision::Milliseconds:
+                return 3;
+            case TimestampPrecision::Microseconds:
+                return 6;
+            default:
+                return 0;
+        }
+    }
+
+    void Format_Date_Time(std::time_t aSecond) {
+        std::tm cTime;
+        localtime_r(&aSecond, &cTime);
+
+        mBuffer[0] = '[';
+        Write_Digits(1, cTime.tm_year + 1900, 4);
+        mBuffer[5] = '-';
+        Write_Digits(6, cTime.tm_mon + 1, 2);
+        mBuffer[8] = '-';
+        Write_Digits(9, cTime.tm_mday, 2);
+        mBuffer[11] = ' ';
+        Write_Digits(12, cTime.tm_hour, 2);
+        mBuffer[14] = ':';
+        Write_Digits(15, cTime.tm_min, 2);
+        mBuffer[17] = ':';
+        Write_Digits(18, cTime.tm_sec, 2);
+        mSecond = aSecond;
+    }
+
+    // aNumDigits decimal digits of aValue at aOffset, zero-padded
+    void Write_Digits(std::size_t aOffset, std::int64_t aValue, int aNumDigits) {
+        for (int cDigit = aNumDigits - 1; cDigit >= 0; --cDigit) {
+            mBuffer[aOffset + cDigit] = static_cast<char>('0' + aValue % 10);
+            aValue /= 10;
+        }
+    }
+
+    TimestampPrecision mPrecision;
+    std::time_t        mSecond = -1;  // Of the formatted date and time
+    std::size_t        mSize;
+    char               mBuffer[sDateTimeSize + 7 + 2];
+};
@@ -0,0 +1,323 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#if __has_include(<linux/io_uring.h>)
+    #include <linux/io_uring.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <span>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "LogSink.hpp"
+
+// Copies records into a few large preallocated buffers and submits each full one as a write
+// through io_uring, so the writing thread doesn't block in write(): it goes back to filling the
+// next buffer while up to sNumBuffers writes are in flight, and a buffer is reused once its write
+// completes. It only waits when every buffer is in flight, and in Flush() and Sync(), which wait
+// for all of them (an async LogWriter flushes when it has caught up, so has nothing else to do).
+//
+// Uses the raw syscalls (no liburing). Where io_uring isn't available (not Linux, an old kernel,
+// or a seccomp filter blocking it), full buffers are written with pwrite() instead.
+class UringSink final : public LogSink {
+  public:
+    static constexpr std::size_t sNumBuffers  = 8;
+    static constexpr std::size_t sBufferBytes = 256 * 1024;
+
+    explicit UringSink(const std::string& aFileName) {
+        // Not O_APPEND: writes go to explicit offsets (pwrite() with O_APPEND ignores them)
+        mFd = open(aFileName.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+        if (mFd < 0)
+            throw std::system_error(errno, std::generic_category(), "open " + aFileName);
+
+        struct stat cStat;
+        if (fstat(mFd, &cStat) != 0) {
+            auto cError = errno;
+            close(mFd);
+            throw std::system_error(cError, std::generic_category(), "fstat");
+        }
+        mFileOffset = static_cast<std::uint64_t>(cStat.st_size);
+
+        mBuffers.resize(sNumBuffers);
+        for (auto& cBuffer : mBuffers)
+            cBuffer.bytes = std::make_unique<char[]>(sBufferBytes);
+        Setup_Ring();
+    }
+
+    // Best effort: destructors can't throw. If Flush() throws, other writes may still be in
+    // flight: they are reaped before the buffers they read from are freed.
+    ~UringSink() override {
+        try {
+            Flush();
+        } catch (const std::exception&) {
+        }
+        Drain();
+        Teardown_Ring();
+        close(mFd);
+    }
+
+    UringSink(const UringSink&)            = delete;
+    UringSink& operator=(const UringSink&) = delete;
+
+    void Write(std::span<const char> aBytes) override {
+        while (!aBytes.empty()) {
+            auto& cBuffer    = mBuffers[mCurrent];
+            auto  cNumToCopy = std::min(aBytes.size(), sBufferBytes - cBuffer.size);
+            std::memcpy(cBuffer.bytes.get() + cBuffer.size, aBytes.data(), cNumToCopy);
+            cBuffer.size += cNumToCopy;
+            aBytes = aBytes.subspan(cNumToCopy);
+            if (cBuffer.size == sBufferBytes)
+                Submit_Current();
+        }
+    }
+
+    // Submits what has been copied, and waits for every write
+    void Flush() override {
+        if (mBuffers[mCurrent].size > 0)
+            Submit_Current();
+        while (mNumInFlight > 0)
+            Reap(true);
+    }
+
+    void Sync() override {
+        Flush();
+        if (fdatasync(mFd) != 0)
+            throw std::system_error(errno, std::generic_category(), "fdatasync");
+    }
+
+    bool is_uring() const { return mRingFd >= 0; }
+
+  private:
+    struct Buffer {
+        std::unique_ptr<char[]> bytes;
+        std::size_t             size         = 0;  // Copied in
+        std::size_t             written      = 0;  // By completed writes
+        std::uint64_t           offset       = 0;  // In the file
+        bool                    is_in_flight = false;
+    };
+
+    // Writes the current buffer at the end of the file, and moves on to the next one (waiting for
+    // its write, if it's still in flight)
+    void Submit_Current() {
+        auto& cBuffer  = mBuffers[mCurrent];
+        cBuffer.offset = mFileOffset;
+        mFileOffset += cBuffer.size;
+        if (!is_uring()) {
+            Write_Blocking(cBuffer);
+            return;
+        }
+
+        cBuffer.is_in_flight = true;
+        ++mNumInFlight;
+        Submit_Write(mCurrent);
+        mCurrent = (mCurrent + 1) % sNumBuffers;
+        while (mBuffers[mCurrent].is_in_flight)
+            Reap(true);
+        Reap(false);  // Recycle what has completed, and surface errors early
+    }
+
+    // Waits for every write in flight, ignoring their errors
+    void Drain() {
+        while (mNumInFlight > 0) {
+            try {
+                Reap(true);
+            } catch (const std::system_error&) {
+                // A failed write (already counted as done), or an interrupted wait: carry on
+            }
+        }
+    }
+
+    // Fallback: the whole buffer, with pwrite()
+    void Write_Blocking(Buffer& aBuffer) {
+        while (aBuffer.written < aBuffer.size) {
+            auto cResult = pwrite(mFd, aBuffer.bytes.get() + aBuffer.written,
+                                  aBuffer.size - aBuffer.written,
+                                  static_cast<off_t>(aBuffer.offset + aBuffer.written));
+            if (cResult < 0) {
+                if (errno == EINTR)
+                    continue;
+                throw std::system_error(errno, std::generic_category(), "pwrite");
+            }
+            aBuffer.written += static_cast<std::size_t>(cResult);
+        }
+        aBuffer.size    = 0;
+        aBuffer.written = 0;
+    }
+
+#if __has_include(<linux/io_uring.h>) && defined(__NR_io_uring_setup)
+    // Leaves mRingFd -1 (pwrite() fallback) if io_uring, or its write operation, isn't available
+    void Setup_Ring() {
+        io_uring_params cParams;
+        std::memset(&cParams, 0, sizeof(cParams));
+        auto cRingFd = static_cast<int>(syscall(__NR_io_uring_setup, sNumBuffers, &cParams));
+        if (cRingFd < 0)
+            return;
+        mRingFd = cRingFd;
+        if (!Is_Write_Supported() || !Map_Ring(cParams))
+            Teardown_Ring();
+    }
+
+    bool Is_Write_Supported() const {
+        constexpr unsigned sNumOps = 256;
+        std::vector<std::byte> cProbeBytes(sizeof(io_uring_probe) +
+                                           sNumOps * sizeof(io_uring_probe_op));
+        auto cProbe = reinterpret_cast<io_uring_probe*>(cProbeBytes.data());
+        if (syscall(__NR_io_uring_register, mRingFd, IORING_REGISTER_PROBE, cProbe, sNumOps) < 0)
+            return false;
+        return (cProbe->last_op >= IORING_OP_WRITE) &&
+               (cProbe->ops[IORING_OP_WRITE].flags & IO_URING_OP_SUPPORTED);
+    }
+
+    bool Map_Ring(const io_uring_params& aParams) {
+        mSqRingBytes = aParams.sq_off.array + aParams.sq_entries * sizeof(unsigned);
+        mCqRingBytes = aParams.cq_off.cqes + aParams.cq_entries * sizeof(io_uring_cqe);
+        bool cIsSingleMap = (aParams.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (cIsSingleMap)
+            mSqRingBytes = mCqRingBytes = std::max(mSqRingBytes, mCqRingBytes);
+
+        mSqRing = Map(mSqRingBytes, IORING_OFF_SQ_RING);
+        if (mSqRing == nullptr)
+            return false;
+        mCqRing = cIsSingleMap ? mSqRing : Map(mCqRingBytes, IORING_OFF_CQ_RING);
+        if (mCqRing == nullptr)
+            return false;
+        mSqesBytes = aParams.sq_entries * sizeof(io_uring_sqe);
+        mSqes      = static_cast<io_uring_sqe*>(Map(mSqesBytes, IORING_OFF_SQES));
+        if (mSqes == nullptr)
+            return false;
+
+        auto cSq = static_cast<char*>(mSqRing);
+        auto cCq = static_cast<char*>(mCqRing);
+        mSqTail  = reinterpret_cast<unsigned*>(cSq + aParams.sq_off.tail);
+        mSqMask  = *reinterpret_cast<unsigned*>(cSq + aParams.sq_off.ring_mask);
+        mSqArray = reinterpret_cast<unsigned*>(cSq + aParams.sq_off.array);
+        mCqHead  = reinterpret_cast<unsigned*>(cCq + aParams.cq_off.head);
+        mCqTail  = reinterpret_cast<unsigned*>(cCq + aParams.cq_off.tail);
+        mCqMask  = *reinterpret_cast<unsigned*>(cCq + aParams.cq_off.ring_mask);
+        mCqes    = reinterpret_cast<io_uring_cqe*>(cCq + aParams.cq_off.cqes);
+        return true;
+    }
+
+    void* Map(std::size_t aNumBytes, off_t aOffset) const {
+        auto cAddress = mmap(nullptr, aNumBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                             mRingFd, aOffset);
+        return (cAddress == MAP_FAILED) ? nullptr : cAddress;
+    }
+
+    void Teardown_Ring() {
+        if (mSqes != nullptr)
+            munmap(mSqes, mSqesBytes);
+        if ((mCqRing != nullptr) && (mCqRing != mSqRing))
+            munmap(mCqRing, mCqRingBytes);
+        if (mSqRing != nullptr)
+            munmap(mSqRing, mSqRingBytes);
+        mSqes   = nullptr;
+        mCqRing = mSqRing = nullptr;
+        if (mRingFd >= 0)
+            close(mRingFd);
+        mRingFd = -1;
+    }
+
+    // Queues a write of what's left of buffer aIndex, and submits it
+    void Submit_Write(std::size_t aIndex) {
+        auto& cBuffer = mBuffers[aIndex];
+        auto  cTail   = *mSqTail;  // Only this thread writes it
+        auto  cSlot   = cTail & mSqMask;
+        auto& cEntry  = mSqes[cSlot];
+        std::memset(&cEntry, 0, sizeof(cEntry));
+        cEntry.opcode    = IORING_OP_WRITE;
+        cEntry.fd        = mFd;
+        cEntry.addr      = reinterpret_cast<std::uint64_t>(cBuffer.bytes.get() + cBuffer.written);
+        cEntry.len       = static_cast<std::uint32_t>(cBuffer.size - cBuffer.written);
+        cEntry.off       = cBuffer.offset + cBuffer.written;
+        cEntry.user_data = aIndex;
+        mSqArray[cSlot]  = cSlot;
+
+        // Release: the kernel must see the entry before the new tail
+        std::atomic_ref<unsigned>(*mSqTail).store(cTail + 1, std::memory_order::release);
+        Enter(1, 0);
+    }
+
+    // Handles completed writes, waiting for at least one if aWait (some must be in flight)
+    void Reap(bool aWait) {
+        auto cHead = *mCqHead;  // Only this thread writes it
+        // Acquire: the completion must be read after the kernel's tail store
+        auto cTail = std::atomic_ref<unsigned>(*mCqTail).load(std::memory_order::acquire);
+        if (aWait && (cHead == cTail))
+            Enter(0, 1);
+
+        while (cHead != std::atomic_ref<unsigned>(*mCqTail).load(std::memory_order::acquire)) {
+            auto cCompletion = mCqes[cHead & mCqMask];
+            ++cHead;
+            std::atomic_ref<unsigned>(*mCqHead).store(cHead, std::memory_order::release);
+
+            auto  cIndex  = static_cast<std::size_t>(cCompletion.user_data);
+            auto& cBuffer = mBuffers[cIndex];
+            if (cCompletion.res <= 0) {
+                cBuffer.is_in_flight = false;
+                --mNumInFlight;
+                auto cError = (cCompletion.res < 0) ? -cCompletion.res : EIO;  // 0: no progress
+                throw std::system_error(cError, std::generic_category(), "io_uring write");
+            }
+
+            cBuffer.written += static_cast<std::size_t>(cCompletion.res);
+            if (cBuffer.written < cBuffer.size) {
+                Submit_Write(cIndex);  // Short write: the rest
+                continue;
+            }
+            cBuffer.size         = 0;
+            cBuffer.written      = 0;
+            cBuffer.is_in_flight = false;
+            --mNumInFlight;
+        }
+    }
+
+    void Enter(unsigned aNumToSubmit, unsigned aMinComplete) {
+        unsigned cFlags = (aMinComplete > 0) ? IORING_ENTER_GETEVENTS : 0;
+        while (syscall(__NR_io_uring_enter, mRingFd, aNumToSubmit, aMinComplete, cFlags, nullptr,
+                       0) < 0) {
+            if (errno != EINTR)
+                throw std::system_error(errno, std::generic_category(), "io_uring_enter");
+        }
+    }
+
+    std::size_t   mSqRingBytes = 0;
+    std::size_t   mCqRingBytes = 0;
+    std::size_t   mSqesBytes   = 0;
+    void*         mSqRing      = nullptr;
+    void*         mCqRing      = nullptr;  // The same as mSqRing with IORING_FEAT_SINGLE_MMAP
+    io_uring_sqe* mSqes        = nullptr;
+    unsigned*     mSqTail      = nullptr;
+    unsigned      mSqMask      = 0;
+    unsigned*     mSqArray     = nullptr;
+    unsigned*     mCqHead      = nullptr;
+    unsigned*     mCqTail      = nullptr;
+    unsigned      mCqMask      = 0;
+    io_uring_cqe* mCqes        = nullptr;
+#else
+    void Setup_Ring() {}
+    void Teardown_Ring() {}
+    void Submit_Write(std::size_t) {}
+    void Reap(bool) {}
+#endif
+
+    int                 mFd         = -1;
+    std::uint64_t       mFileOffset = 0;  // Where the next buffer goes
+    std::vector<Buffer> mBuffers;
+    std::size_t         mCurrent     = 0;  // Being filled
+    std::size_t         mNumInFlight = 0;
+    int                 mRingFd      = -1;
+};
@@ -0,0 +1,117 @@
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <string_view>
+
+#include "LogFile.hpp"
+#include "MergedLog.hpp"
+
+// Cost of a log call, and how many heap allocations it makes on the logging thread: building the
+// message as a std::string (the old API) against a string_view and against formatting straight
+// into the log's record buffer (Log() with arguments, here through LOG_INFO). In steady state the
+// latter two should report 0 allocs/call.
+//
+// Argument: 0 for LogMode::Sync, 1 for LogMode::Async. Records go to log_bench.txt, which is
+// removed afterwards.
+
+// Allocations by this thread: only the logging thread's count, not the writer's or collector's
+thread_local std::int64_t tNumAllocations = 0;
+
+void* operator new(std::size_t aSize) {
+    ++tNumAllocations;
+    if (auto cMemory = std::malloc(aSize ? aSize : 1))
+        return cMemory;
+    throw std::bad_alloc();
+}
+
+// Not inlined: GCC would see free() on memory from operator new (-Wmismatched-new-delete)
+[[gnu::noinline]] void operator delete(void* aMemory) noexcept { std::free(aMemory); }
+[[gnu::noinline]] void operator delete(void* aMemory, std::size_t) noexcept { std::free(aMemory); }
+
+constexpr const char* sFileName = "log_bench.txt";
+
+LogOptions Options(const benchmark::State& aState) {
+    LogOptions cOptions;
+    cOptions.mode = aState.range(0) ? LogMode::Async : LogMode::Sync;
+    return cOptions;
+}
+
+void Report_Allocations(benchmark::State& aState, std::int64_t aNumAllocations) {
+    aState.counters["allocs/call"] =
+        static_cast<double>(aNumAllocations) / static_cast<double>(aState.iterations());
+    aState.SetItemsProcessed(aState.iterations());
+}
+
+void BM_Log_String(benchmark::State& state) {
+    std::int64_t cNumAllocations = 0;
+    {
+        LogFile log(sFileName, Options(state));
+        std::int64_t cOrder = 0;
+        double       cPrice = 101.25;
+        auto         cStart = tNumAllocations;
+        for (auto _ : state) {
+            log << "Order " + std::to_string(++cOrder) + " filled at " + std::to_string(cPrice) +
+                       " (XNYS)";
+        }
+        cNumAllocations = tNumAllocations - cStart;
+    }
+    Report_Allocations(state, cNumAllocations);
+    std::remove(sFileName);
+}
+
+void BM_Log_View(benchmark::State& state) {
+    std::int64_t cNumAllocations = 0;
+    {
+        LogFile log(sFileName, Options(state));
+        auto    cStart = tNumAllocations;
+        for (auto _ : state)
+            log << std::string_view("Order filled, price and venue unknown to this benchmark");
+        cNumAllocations = tNumAllocations - cStart;
+    }
+    Report_Allocations(state, cNumAllocations);
+    std::remove(sFileName);
+}
+
+void BM_Log_Format(benchmark::State& state) {
+    std::int64_t cNumAllocations = 0;
+    {
+        LogFile          log(sFileName, Options(state));
+        std::int64_t     cOrder = 0;
+        double           cPrice = 101.25;
+        std::string_view cVenue = "XNYS";
+        auto             cStart = tNumAllocations;
+        for (auto _ : state)
+            LOG_INFO(log, "Order {} filled at {} ({})", ++cOrder, cPrice, cVenue);
+        cNumAllocations = tNumAllocations - cStart;
+    }
+    Report_Allocations(state, cNumAllocations);
+    std::remove(sFileName);
+}
+
+void BM_Merged_Format(benchmark::State& state) {
+    std::int64_t cNumAllocations = 0;
+    {
+        MergedLogFile    log(sFileName);
+        std::int64_t     cOrder = 0;
+        double           cPrice = 101.25;
+        std::string_view cVenue = "XNYS";
+        auto             cStart = tNumAllocations;
+        for (auto _ : state)
+            LOG_INFO(log, "Order {} filled at {} ({})", ++cOrder, cPrice, cVenue);
+        cNumAllocations = tNumAllocations - cStart;
+    }
+    Report_Allocations(state, cNumAllocations);
+    std::remove(sFileName);
+}
+
+BENCHMARK(BM_Log_String)->Arg(0)->Arg(1);
+BENCHMARK(BM_Log_View)->Arg(0)->Arg(1);
+BENCHMARK(BM_Log_Format)->Arg(0)->Arg(1);
+BENCHMARK(BM_Merged_Format);
+
+BENCHMARK_MAIN();
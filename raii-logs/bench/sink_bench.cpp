@@ -0,0 +1,64 @@
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+#include "LogFile.hpp"
+
+// Write throughput of the sinks: std::fstream (StreamSink), memory-mapped (MappedSink) and
+// io_uring (UringSink, or its pwrite() fallback, labelled). Two views:
+//   BM_Sink_Write - the sink alone, written in the async writer's batches (64 KiB), flushed at the
+//                   end: how long the writer thread spends per batch
+//   BM_Async_Log  - records through an async LogFile: what a logging thread sustains while the
+//                   writer keeps up
+//
+// Argument: the SinkType (0 Stream, 1 Mapped, 2 Uring). Files go to sink_bench.log, removed
+// after each run. Results depend heavily on the file system and on whether the page cache absorbs
+// the writes: run on the disk the logs will live on.
+
+constexpr const char* sFileName   = "sink_bench.log";
+constexpr std::size_t sBatchBytes = 64 * 1024;
+
+SinkType Sink_Type(const benchmark::State& aState) {
+    return static_cast<SinkType>(aState.range(0));
+}
+
+void Label_Fallback(benchmark::State& aState) {
+    if (Sink_Type(aState) == SinkType::Uring && !UringSink(sFileName).is_uring())
+        aState.SetLabel("io_uring unavailable: pwrite fallback");
+}
+
+void BM_Sink_Write(benchmark::State& state) {
+    Label_Fallback(state);
+    std::vector<char> cBatch(sBatchBytes, 'x');
+    for (std::size_t cIndex = 99; cIndex < cBatch.size(); cIndex += 100)
+        cBatch[cIndex] = '\n';
+    {
+        auto cSink = Open_Sink(Sink_Type(state), sFileName);
+        for (auto _ : state)
+            cSink->Write(cBatch);
+        cSink->Flush();
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<std::int64_t>(sBatchBytes));
+    std::remove(sFileName);
+}
+
+void BM_Async_Log(benchmark::State& state) {
+    Label_Fallback(state);
+    {
+        LogFile      log(sFileName, {.mode = LogMode::Async, .sink = Sink_Type(state)});
+        std::int64_t cOrder = 0;
+        for (auto _ : state)
+            LOG_INFO(log, "Order {} filled at {} ({})", ++cOrder, 101.25, "XNYS");
+    }
+    state.SetItemsProcessed(state.iterations());
+    std::remove(sFileName);
+}
+
+BENCHMARK(BM_Sink_Write)->DenseRange(0, 2);
+BENCHMARK(BM_Async_Log)->DenseRange(0, 2);
+
+BENCHMARK_MAIN();
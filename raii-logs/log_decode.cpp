@@ -0,0 +1,194 @@
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "BinaryFormat.hpp"
+#include "Timestamp.hpp"
+
+// Decodes binary logs (BinaryLog.hpp) to text, in LogFile's format:
+//   ./log_decode app.rlog [more.rlog...] > app.log
+// A record cut short at the end of a file (the process died mid-write) is reported and skipped.
+namespace {
+
+using binary_log::ArgType;
+
+struct Format {
+    std::vector<ArgType> arg_types;
+    std::string          text;
+};
+
+class Decoder {
+  public:
+    explicit Decoder(std::span<const char> aBytes) : mBytes(aBytes) {}
+
+    // Writes the text of every record to aOutput. False if the log ends mid-record.
+    bool Decode(std::FILE* aOutput) {
+        while (mOffset < mBytes.size()) {
+            auto cStart = mOffset;
+            try {
+                switch (Read<char>()) {
+                    case binary_log::sHeaderTag:
+                        Read_Header();
+                        break;
+                    case binary_log::sFormatTag:
+                        Read_Format();
+                        break;
+                    case binary_log::sEntryTag:
+                        Read_Entry();
+                        std::fwrite(mLine.data(), 1, mLine.size(), aOutput);
+                        break;
+                    default:
+                        throw std::runtime_error("Unknown record at offset " +
+                                                 std::to_string(cStart));
+                }
+            } catch (const std::out_of_range&) {
+                std::fprintf(stderr, "Truncated record at offset %zu\n", cStart);
+                return false;
+            }
+        }
+        return true;
+    }
+
+  private:
+    template <typename ValueType>
+    ValueType Read() {
+        ValueType cValue;
+        std::memcpy(&cValue, Read_Bytes(sizeof(cValue)).data(), sizeof(cValue));
+        return cValue;
+    }
+
+    std::string_view Read_Bytes(std::size_t aSize) {
+        if (aSize > mBytes.size() - mOffset)
+            throw std::out_of_range("Past the end of the log");
+        auto cBytes = std::string_view(mBytes.data() + mOffset, aSize);
+        mOffset += aSize;
+        return cBytes;
+    }
+
+    void Read_Header() {
+        if (Read_Bytes(sizeof(binary_log::sMagic) - 1) != binary_log::sMagic)
+            throw std::runtime_error("Not a binary log");
+        if (Read<std::uint8_t>() != binary_log::sVersion)
+            throw std::runtime_error("Unsupported binary log version");
+        auto cPrecision = static_cast<TimestampPrecision>(Read<std::uint8_t>());
+        if (Read<std::uint32_t>() != binary_log::sBinaryByteOrderMark)
+            throw std::runtime_error("Binary log written with a different byte order");
+
+        mTimestamps = TimestampCache(cPrecision);
+        mFormats.clear();  // Ids are per writing process
+    }
+
+    void Read_Format() {
+        auto   cFormatId = Read<std::uint32_t>();
+        Format cFormat;
+        cFormat.arg_types.resize(Read<std::uint8_t>());
+        for (auto& cType : cFormat.arg_types)
+            cType = Read<ArgType>();
+        cFormat.text = Read_Bytes(Read<std::uint32_t>());
+        mFormats[cFormatId] = std::move(cFormat);
+    }
+
+    void Read_Entry() {
+        auto cFormatId   = Read<std::uint32_t>();
+        auto cNanosecond = Read<std::int64_t>();
+        auto cFound      = mFormats.find(cFormatId);
+        if (cFound == mFormats.end())
+            throw std::runtime_error("Entry before its format, id " + std::to_string(cFormatId));
+
+        mArguments.clear();
+        for (auto cType : cFound->second.arg_types)
+            mArguments.push_back(Read_Argument(cType));
+
+        timespec cTime;
+        cTime.tv_sec  = cNanosecond / 1'000'000'000;
+        cTime.tv_nsec = cNanosecond % 1'000'000'000;
+        mLine.assign(mTimestamps.Prefix(cTime));
+        Substitute(cFound->second.text);
+        mLine.push_back('\n');
+    }
+
+    std::string Read_Argument(ArgType aType) {
+        switch (aType) {
+            case ArgType::Int:
+                return std::to_string(Read<std::int64_t>());
+            case ArgType::UInt:
+                return std::to_string(Read<std::uint64_t>());
+            case ArgType::Double: {
+                char cText[32];  // Shortest text that reads back as the same double
+                auto cResult = std::to_chars(cText, cText + sizeof(cText), Read<double>());
+                return std::string(cText, cResult.ptr);
+            }
+            case ArgType::Bool:
+                return Read<char>() ? "true" : "false";
+            case ArgType::Char:
+                return std::string(1, Read<char>());
+            case ArgType::String:
+                return std::string(Read_Bytes(Read<std::uint32_t>()));
+        }
+        throw std::runtime_error("Unknown argument type " +
+                                 std::to_string(static_cast<int>(aType)));
+    }
+
+    // "{}" -> the next argument, "{{" -> "{", "}}" -> "}". Arguments beyond the placeholders are
+    // appended, so nothing logged is lost to a mismatched format.
+    void Substitute(std::string_view aFormat) {
+        std::size_t cArgument = 0;
+        for (std::size_t cIndex = 0; cIndex < aFormat.size(); ++cIndex) {
+            auto cNext = (cIndex + 1 < aFormat.size()) ? aFormat[cIndex + 1] : '\0';
+            if ((aFormat[cIndex] == '{') && (cNext == '}') && (cArgument < mArguments.size())) {
+                mLine += mArguments[cArgument++];
+                ++cIndex;
+            } else if (((aFormat[cIndex] == '{') || (aFormat[cIndex] == '}')) &&
+                       (cNext == aFormat[cIndex])) {
+                mLine += aFormat[cIndex];
+                ++cIndex;
+            } else
+                mLine += aFormat[cIndex];
+        }
+        for (; cArgument < mArguments.size(); ++cArgument)
+            mLine += " " + mArguments[cArgument];
+    }
+
+    std::span<const char>           mBytes;
+    std::size_t                     mOffset = 0;
+    std::map<std::uint32_t, Format> mFormats;
+    TimestampCache                  mTimestamps;
+    std::vector<std::string>        mArguments;
+    std::string                     mLine;
+};
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "Usage: %s <binary log>... > <text log>\n", argv[0]);
+        return 1;
+    }
+
+    bool isComplete = true;
+    for (int arg = 1; arg < argc; ++arg) {
+        std::ifstream file(argv[arg], std::ios::binary);
+        if (!file) {
+            std::fprintf(stderr, "Can't open %s\n", argv[arg]);
+            return 1;
+        }
+        std::vector<char> bytes(std::istreambuf_iterator<char>(file), {});
+
+        try {
+            isComplete = Decoder(bytes).Decode(stdout) && isComplete;
+        } catch (const std::exception& error) {
+            std::fprintf(stderr, "%s: %s\n", argv[arg], error.what());
+            return 1;
+        }
+    }
+    return isComplete ? 0 : 2;
+}
@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <charconv>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "BinaryLog.hpp"
+#include "log_test_utils.hpp"
+
+// Runs log_decode (built alongside, see CMakeLists.txt) on aPath: its output lines, and its
+// exit code
+std::pair<std::vector<std::string>, int> Decode(const std::string& aPath) {
+    auto command = std::string(LOG_DECODE_PATH) + " " + aPath;
+    auto pipe    = popen(command.c_str(), "r");
+    if (pipe == nullptr)
+        return {{}, -1};
+
+    std::vector<std::string> lines;
+    std::string              line;
+    for (int c; (c = std::fgetc(pipe)) != EOF;) {
+        if (c == '\n')
+            lines.push_back(std::exchange(line, {}));
+        else
+            line.push_back(static_cast<char>(c));
+    }
+    auto status = pclose(pipe);
+    return {lines, WIFEXITED(status) ? WEXITSTATUS(status) : -1};
+}
+
+class BinaryLogTest : public ::testing::TestWithParam<LogMode> {
+  protected:
+    void SetUp() override { path_ = Temp_Path("binary.rlog"); }
+    void TearDown() override { Remove_All(path_); }
+
+    std::string path_;
+};
+
+TEST_P(BinaryLogTest, DecodesToTheSameMessages) {
+    constexpr int            num_records = 10000;
+    const std::vector<char>  venues      = {'N', 'L', 'X'};
+    std::vector<std::string> expected    = {"LOG OPENED"};
+    {
+        BinaryLogFile log(path_, {.mode = GetParam(), .queue_bytes = 4096});
+        for (int i = 0; i < num_records; ++i) {
+            auto venue = "Venue " + std::string(i % 20, 'v');
+            BINARY_LOG(log, "Order {} ({}) at {}: {}, {} {{{}}}", i, -i, i * 0.25, i % 2 == 0,
+                       venues[i % 3], venue);
+            char price[32];
+            auto end = std::to_chars(price, price + sizeof(price), i * 0.25).ptr;
+            expected.push_back("Order " + std::to_string(i) + " (" + std::to_string(-i) + ") at " +
+                               std::string(price, end) + ": " + (i % 2 == 0 ? "true" : "false") +
+                               ", " + venues[i % 3] + " {" + venue + "}");
+        }
+        // An argument the format has no placeholder for is still decoded
+        BINARY_LOG(log, "Unsigned", 42u);
+        expected.push_back("Unsigned 42");
+    }
+    expected.push_back("LOG CLOSED");
+
+    auto [lines, exit_code] = Decode(path_);
+    EXPECT_EQ(exit_code, 0);
+    ASSERT_EQ(lines.size(), expected.size());
+    for (std::size_t i = 0; i < lines.size(); ++i)
+        ASSERT_EQ(Message(lines[i]), expected[i]) << "Record " << i;
+}
+
+TEST_P(BinaryLogTest, TruncatedLogDecodesUpToTheCut) {
+    {
+        BinaryLogFile log(path_, {.mode = GetParam()});
+        BINARY_LOG(log, "Record {}", 1);
+        BINARY_LOG(log, "Record {}", 2);
+    }
+    // Cuts into LOG CLOSED, as if the process died writing it
+    std::filesystem::resize_file(path_, std::filesystem::file_size(path_) - 3);
+
+    auto [lines, exit_code] = Decode(path_);
+    EXPECT_EQ(exit_code, 2);
+    ASSERT_EQ(lines.size(), static_cast<size_t>(3));
+    EXPECT_EQ(Message(lines.back()), "Record 2");
+}
+
+INSTANTIATE_TEST_SUITE_P(Modes, BinaryLogTest, ::testing::Values(LogMode::Sync, LogMode::Async));
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,168 @@
+#include <gtest/gtest.h>
+
+#include <cerrno>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+#include "LogFile.hpp"
+#include "log_test_utils.hpp"
+
+// Text logs through each sink, in async mode
+class LogFileTest : public ::testing::TestWithParam<SinkType> {
+  protected:
+    void SetUp() override { path_ = Temp_Path("log_file.log"); }
+    void TearDown() override { Remove_All(path_); }
+
+    std::string path_;
+};
+
+TEST_P(LogFileTest, LogClosedIsLastAfterAsyncDrain) {
+    constexpr int num_records = 20000;
+    {
+        // A small ring: the logging thread outruns the writer, which has to drain it on close
+        LogFile log(path_, {.mode = LogMode::Async, .sink = GetParam(), .queue_bytes = 4096});
+        for (int i = 0; i < num_records; ++i)
+            log << "Record " + std::to_string(i);
+    }
+
+    auto lines = Read_Lines(path_);
+    ASSERT_EQ(lines.size(), static_cast<size_t>(num_records + 2));
+    EXPECT_EQ(Message(lines.front()), "LOG OPENED");
+    EXPECT_EQ(Message(lines[num_records]), "Record " + std::to_string(num_records - 1));
+    EXPECT_EQ(Message(lines.back()), "LOG CLOSED");
+}
+
+TEST_P(LogFileTest, NoLostOrTornRecordsUnderLoad) {
+    // Sizes from 0 to a few KiB, so records straddle the ring's wrap-around and the writer's
+    // batches (and the uring sink's buffers)
+    constexpr int num_records = 50000;
+    auto          padding     = [](int aIndex) {
+        return std::string(aIndex % 4099, static_cast<char>('a' + aIndex % 26));
+    };
+    {
+        LogFile log(path_, {.mode = LogMode::Async, .sink = GetParam(), .queue_bytes = 16384});
+        for (int i = 0; i < num_records; ++i)
+            log << std::to_string(i) + " " + padding(i);
+    }
+
+    auto lines = Read_Lines(path_);
+    ASSERT_EQ(lines.size(), static_cast<size_t>(num_records + 2));
+    for (int i = 0; i < num_records; ++i) {
+        auto expected = std::to_string(i) + " " + padding(i);
+        ASSERT_EQ(Message(lines[i + 1]), expected) << "Record " << i;
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(Sinks, LogFileTest,
+                         ::testing::Values(SinkType::Stream, SinkType::Mapped, SinkType::Uring));
+
+TEST(LogFileLevelsTest, RecordsBelowTheThresholdAreDropped) {
+    auto path = Temp_Path("levels.log");
+    {
+        LogFile log(path, {.level = LogLevel::Warn});
+        LOG_INFO(log, "Dropped {}", 1);
+        LOG_WARN(log, "Kept {}", 2);
+        log.Set_Level(LogLevel::Trace);
+        LOG_DEBUG(log, "Kept {}", 3);
+    }
+
+    auto lines = Read_Lines(path);
+    ASSERT_EQ(lines.size(), static_cast<size_t>(4));
+    EXPECT_EQ(Message(lines[1]), "WARN  Kept 2");
+    EXPECT_EQ(Message(lines[2]), "DEBUG Kept 3");
+    Remove_All(path);
+}
+
+TEST(LogFileLevelsTest, DisabledStatementsDontEvaluateTheirArguments) {
+    auto path = Temp_Path("levels.log");
+    {
+        LogFile log(path, {.level = LogLevel::Off});
+        int     num_evaluated = 0;
+        LOG_ERROR(log, "{}", ++num_evaluated);
+        EXPECT_EQ(num_evaluated, 0);
+    }
+    EXPECT_EQ(Read_Lines(path).size(), static_cast<size_t>(2));
+    Remove_All(path);
+}
+
+TEST(LogWriterTest, GroupImpliesAsync) {
+    LogWriter writer(std::make_unique<MemorySink>(), LogMode::Sync, 4096, LogDurability::Group);
+    EXPECT_EQ(writer.mode(), LogMode::Async);
+}
+
+TEST(LogWriterTest, WaitDurableUnderGroup) {
+    // Neither the record count nor the interval is reached: Wait_Durable() needs the writer to
+    // sync on its own, at most an interval later
+    auto  sink  = std::make_unique<MemorySink>();
+    auto& bytes = *sink;
+    LogWriter writer(std::move(sink), LogMode::Async, 4096, LogDurability::Group,
+                     {.records = 1'000'000, .interval = std::chrono::milliseconds(20)});
+
+    std::string record = "A record\n";
+    std::size_t total  = 0;
+    for (int round = 0; round < 3; ++round) {
+        for (int i = 0; i < 1000; ++i) {
+            writer.Write(record);
+            total += record.size();
+        }
+        writer.Wait_Durable();
+        EXPECT_EQ(bytes.synced_bytes, total);
+    }
+}
+
+TEST(LogWriterTest, WaitDurableSyncsOnDemandWhenBuffered) {
+    for (auto durability : {LogDurability::Buffered, LogDurability::Flush}) {
+        auto      sink  = std::make_unique<MemorySink>();
+        auto&     bytes = *sink;
+        LogWriter writer(std::move(sink), LogMode::Async, 4096, durability);
+
+        std::string record = "A record\n";
+        for (int i = 0; i < 1000; ++i)
+            writer.Write(record);
+        writer.Wait_Durable();
+        EXPECT_EQ(bytes.synced_bytes, 1000 * record.size());
+    }
+}
+
+TEST(LogWriterTest, WriterErrorsAreRethrown) {
+    for (auto durability : {LogDurability::Buffered, LogDurability::Sync, LogDurability::Group}) {
+        LogWriter writer(std::make_unique<FailingSink>(2), LogMode::Async, 4096, durability);
+
+        // Logging carries on (records are dropped) rather than blocking on the full ring
+        std::string record(100, 'x');
+        bool        was_rethrown = false;
+        for (int i = 0; i < 1000; ++i) {
+            try {
+                writer.Write(record);
+                writer.Wait_Durable();
+            } catch (const std::runtime_error&) {
+                was_rethrown = true;
+            }
+        }
+        EXPECT_TRUE(was_rethrown);
+        EXPECT_THROW(writer.Close(), std::runtime_error);
+    }
+}
+
+TEST(LogWriterTest, StreamSinkErrorsAreRethrown) {
+    // A full disk: the stream buffers the bytes, then can't write them
+    for (auto mode : {LogMode::Sync, LogMode::Async}) {
+        LogWriter writer(std::make_unique<StreamSink>("/dev/full"), mode, 4096);
+        writer.Write(std::string_view("A record\n"));
+        try {
+            writer.Wait_Durable();
+            ADD_FAILURE() << "Nothing was rethrown";
+        } catch (const std::system_error& error) {
+            EXPECT_EQ(error.code().value(), ENOSPC);
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
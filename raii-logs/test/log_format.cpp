@@ -0,0 +1,55 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "LogFormat.hpp"
+
+template <typename... ArgumentTypes>
+std::string Format(std::string_view aFormat, const ArgumentTypes&... aArguments) {
+    std::string buffer;
+    Format_To(buffer, aFormat, aArguments...);
+    return buffer;
+}
+
+TEST(FormatToTest, FillsPlaceholdersInOrder) {
+    EXPECT_EQ(Format("Order {} filled at {} ({})", 42, 101.25, "XNYS"),
+              "Order 42 filled at 101.25 (XNYS)");
+    EXPECT_EQ(Format("No placeholders", 1), "No placeholders");
+}
+
+TEST(FormatToTest, FormatsEachArgumentType) {
+    std::string      text = "string";
+    std::string_view view = "view";
+    EXPECT_EQ(Format("{} {} {} {}", -7, std::uint64_t{18'446'744'073'709'551'615u}, short{3},
+                     static_cast<unsigned char>(200)),
+              "-7 18446744073709551615 3 200");
+    EXPECT_EQ(Format("{} {} {}", 0.1, 1e300, 2.5f), "0.1 1e+300 2.5");
+    EXPECT_EQ(Format("{} {} {}", true, false, 'x'), "true false x");
+    EXPECT_EQ(Format("{} {} {}", "literal", text, view), "literal string view");
+}
+
+TEST(FormatToTest, UnescapesBraces) {
+    EXPECT_EQ(Format("{{{}}} {{}}", 1), "{1} {}");
+}
+
+TEST(FormatToTest, MismatchedFormatsDontThrow) {
+    // The same with and without std::format: nothing is lost, and nothing throws
+    EXPECT_EQ(Format("{} and {}", 1), "1 and {}");
+    EXPECT_EQ(Format("{}", 1, 2), "1");
+    EXPECT_EQ(Format("Stray { and } {}", 1), "Stray { and } 1");
+    EXPECT_EQ(Format("Unclosed {", 1), "Unclosed {");
+}
+
+TEST(FormatToTest, AppendsToTheBuffer) {
+    std::string buffer = "[prefix] ";
+    Format_To(buffer, "{}", 1);
+    Format_To(buffer, " and {}", 2);
+    EXPECT_EQ(buffer, "[prefix] 1 and 2");
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
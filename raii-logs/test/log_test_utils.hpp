@@ -0,0 +1,74 @@
+#pragma once
+
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "LogSink.hpp"
+
+// A file name in the test temp directory, unique to this process
+inline std::string Temp_Path(const std::string& aName) {
+    return ::testing::TempDir() + "raii_logs_" + std::to_string(getpid()) + "_" + aName;
+}
+
+// Removes aPath and every file whose name starts with it (rotated files)
+inline void Remove_All(const std::string& aPath) {
+    auto path   = std::filesystem::path(aPath);
+    auto prefix = path.filename().string();
+    for (const auto& entry : std::filesystem::directory_iterator(path.parent_path())) {
+        if (entry.path().filename().string().starts_with(prefix))
+            std::filesystem::remove(entry.path());
+    }
+}
+
+inline std::string Read_File(const std::string& aPath) {
+    std::ifstream file(aPath, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), {});
+}
+
+inline std::vector<std::string> Read_Lines(const std::string& aPath) {
+    std::ifstream            file(aPath, std::ios::binary);
+    std::vector<std::string> lines;
+    for (std::string line; std::getline(file, line);)
+        lines.push_back(line);
+    return lines;
+}
+
+// A record's message: what follows its "[...] " timestamp prefix
+inline std::string Message(const std::string& aLine) {
+    auto end = aLine.find("] ");
+    return (end == std::string::npos) ? std::string() : aLine.substr(end + 2);
+}
+
+// Keeps what is written in memory, and how much of it was synced
+class MemorySink final : public LogSink {
+  public:
+    void Write(std::span<const char> aBytes) override {
+        bytes.insert(bytes.end(), aBytes.begin(), aBytes.end());
+    }
+    void Sync() override { synced_bytes = bytes.size(); }
+
+    std::vector<char> bytes;
+    std::size_t       synced_bytes = 0;
+};
+
+// Throws once aNumWrites writes have succeeded, as a full disk would
+class FailingSink final : public LogSink {
+  public:
+    explicit FailingSink(int aNumWrites) : num_writes_left(aNumWrites) {}
+
+    void Write(std::span<const char>) override {
+        if (num_writes_left-- <= 0)
+            throw std::runtime_error("Disk full");
+    }
+    void Sync() override {}
+
+    int num_writes_left;
+};
@@ -0,0 +1,78 @@
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include "MappedSink.hpp"
+#include "log_test_utils.hpp"
+
+class MappedSinkTest : public ::testing::Test {
+  protected:
+    void SetUp() override {
+        path_        = Temp_Path("mapped.log");
+        chunk_bytes_ = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    }
+    void TearDown() override { Remove_All(path_); }
+
+    std::string path_;
+    std::size_t chunk_bytes_ = 0;
+};
+
+TEST_F(MappedSinkTest, TruncatesToTheBytesWrittenOnClose) {
+    {
+        MappedSink sink(path_, chunk_bytes_);
+        sink.Write(std::string_view("A record\n"));
+        sink.Sync();
+
+        // Grown by a whole chunk meanwhile
+        EXPECT_EQ(std::filesystem::file_size(path_), chunk_bytes_);
+        EXPECT_EQ(sink.size(), static_cast<size_t>(9));
+    }
+    EXPECT_EQ(Read_File(path_), "A record\n");
+}
+
+TEST_F(MappedSinkTest, GrowsAcrossChunks) {
+    // Writes that end mid-page, and some larger than a chunk
+    std::string expected;
+    {
+        MappedSink sink(path_, chunk_bytes_);
+        for (std::size_t size = 1; size < 3 * chunk_bytes_; size = size * 3 + 1) {
+            auto bytes = std::string(size, static_cast<char>('a' + size % 26));
+            sink.Write(bytes);
+            expected += bytes;
+        }
+    }
+    EXPECT_EQ(Read_File(path_), expected);
+}
+
+TEST_F(MappedSinkTest, ReopeningAppends) {
+    {
+        MappedSink sink(path_, chunk_bytes_);
+        sink.Write(std::string_view("First\n"));
+    }
+    {
+        MappedSink sink(path_, chunk_bytes_);
+        EXPECT_EQ(sink.size(), static_cast<size_t>(6));
+        sink.Write(std::string_view("Second\n"));
+    }
+    EXPECT_EQ(Read_File(path_), "First\nSecond\n");
+}
+
+TEST_F(MappedSinkTest, ReopeningAfterACrashAppendsAfterTheZeros) {
+    // As a crash leaves it: the records, then the rest of the chunk
+    auto crashed = std::string("First\n") + std::string(chunk_bytes_ - 6, '\0');
+    std::ofstream(path_, std::ios::binary) << crashed;
+    {
+        MappedSink sink(path_, chunk_bytes_);
+        sink.Write(std::string_view("Second\n"));
+    }
+    EXPECT_EQ(Read_File(path_), crashed + "Second\n");
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
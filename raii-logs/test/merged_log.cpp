@@ -0,0 +1,139 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "MergedLog.hpp"
+#include "log_test_utils.hpp"
+
+// A record's "[...]" timestamp: fixed width, so they compare as text
+std::string Timestamp(const std::string& aLine) {
+    return aLine.substr(0, aLine.find("] "));
+}
+
+// Throws when formatted, with or without std::format
+struct Unformattable {
+    operator std::string_view() const { throw std::runtime_error("Can't format"); }
+};
+
+#if defined(__cpp_lib_format)
+template <>
+struct std::formatter<Unformattable> : std::formatter<std::string_view> {
+    auto format(const Unformattable&, std::format_context& aContext) const {
+        throw std::runtime_error("Can't format");
+        return aContext.out();
+    }
+};
+#endif
+
+class MergedLogTest : public ::testing::Test {
+  protected:
+    void SetUp() override { path_ = Temp_Path("merged.log"); }
+    void TearDown() override { Remove_All(path_); }
+
+    std::string path_;
+};
+
+TEST_F(MergedLogTest, RecordsAreInTimestampOrder) {
+    constexpr int num_threads = 4;
+    constexpr int num_records = 20000;
+    {
+        MergedLogFile log(path_, {.precision = TimestampPrecision::Microseconds});
+        std::vector<std::thread> threads;
+        for (int thread = 0; thread < num_threads; ++thread) {
+            threads.emplace_back([&log, thread] {
+                for (int i = 0; i < num_records; ++i)
+                    log << "Thread " + std::to_string(thread) + " record " + std::to_string(i);
+            });
+        }
+        for (auto& thread : threads)
+            thread.join();
+        EXPECT_EQ(log.num_threads(), static_cast<size_t>(num_threads + 1));
+    }
+
+    auto lines = Read_Lines(path_);
+    ASSERT_EQ(lines.size(), static_cast<size_t>(num_threads * num_records + 2));
+    EXPECT_EQ(Message(lines.front()), "LOG OPENED");
+    EXPECT_EQ(Message(lines.back()), "LOG CLOSED");
+
+    // Merged by timestamp, and each thread's records in the order it logged them
+    std::vector<int> next(num_threads, 0);
+    for (std::size_t i = 1; i < lines.size(); ++i) {
+        ASSERT_LE(Timestamp(lines[i - 1]), Timestamp(lines[i])) << "Line " << i;
+        if (i + 1 == lines.size())
+            break;
+
+        int  thread = 0, record = 0;
+        auto message = Message(lines[i]);
+        ASSERT_EQ(std::sscanf(message.c_str(), "Thread %d record %d", &thread, &record), 2)
+            << message;
+        ASSERT_EQ(record, next[thread]++) << "Thread " << thread;
+    }
+    for (int thread = 0; thread < num_threads; ++thread)
+        EXPECT_EQ(next[thread], num_records) << "Thread " << thread;
+}
+
+TEST_F(MergedLogTest, ThreadsOutliveClosedLogs) {
+    // A thread's buffers of closed logs are dropped, and a new log (maybe at the same address)
+    // doesn't reuse them
+    constexpr int num_logs = 50;
+    for (int i = 0; i < num_logs; ++i) {
+        {
+            MergedLogFile log(path_);
+            log << "Record " + std::to_string(i);
+        }
+        auto lines = Read_Lines(path_);
+        ASSERT_GE(lines.size(), static_cast<size_t>(3));
+        EXPECT_EQ(Message(lines[lines.size() - 2]), "Record " + std::to_string(i));
+        EXPECT_EQ(Message(lines.back()), "LOG CLOSED");
+    }
+}
+
+TEST_F(MergedLogTest, AThrowingLogCallDoesntStallTheCollector) {
+    MergedLogFile log(path_);
+    std::thread([&log] {
+        EXPECT_THROW(LOG_INFO(log, "{}", Unformattable{}), std::runtime_error);
+    }).join();
+
+    // Written while the log is open: the collector doesn't wait on the thread that threw
+    log << "After";
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while ((Read_Lines(path_).size() < 2) && (std::chrono::steady_clock::now() < deadline))
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    auto lines = Read_Lines(path_);
+    ASSERT_EQ(lines.size(), static_cast<size_t>(2));
+    EXPECT_EQ(Message(lines.back()), "After");
+}
+
+TEST_F(MergedLogTest, WaitDurableUnderGroup) {
+    // Too many records and too long an interval for a group commit: Wait_Durable() has to ask
+    MergedLogFile log(path_, {.durability = LogDurability::Group,
+                              .group      = {.records = 1'000'000,
+                                             .interval = std::chrono::seconds(60)}});
+    for (int round = 0; round < 3; ++round) {
+        for (int i = 0; i < 1000; ++i)
+            log << "Round " + std::to_string(round) + " record " + std::to_string(i);
+        log.Wait_Durable();
+
+        auto lines = Read_Lines(path_);
+        ASSERT_EQ(lines.size(), static_cast<size_t>(1 + (round + 1) * 1000));
+        EXPECT_EQ(Message(lines.back()), "Round " + std::to_string(round) + " record 999");
+    }
+}
+
+TEST_F(MergedLogTest, WaitDurableSyncsOnDemandWhenBuffered) {
+    MergedLogFile log(path_);
+    log << "Record";
+    log.Wait_Durable();
+    EXPECT_EQ(Message(Read_Lines(path_).back()), "Record");
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
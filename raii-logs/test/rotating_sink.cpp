@@ -0,0 +1,159 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "LogFile.hpp"
+#include "RotatingSink.hpp"
+#include "log_test_utils.hpp"
+
+// Rotated files of aPath, oldest first, then aPath
+std::vector<std::string> Log_Files(const std::string& aPath) {
+    auto                     path = std::filesystem::path(aPath);
+    std::vector<std::string> rotated;
+    for (const auto& entry : std::filesystem::directory_iterator(path.parent_path())) {
+        auto name = entry.path().string();
+        if (name.starts_with(aPath + ".") && !name.ends_with(".pending"))
+            rotated.push_back(name);
+    }
+    // "<name>.<YYYYmmdd-HHMMSS>-<n>": by time, then by n as a number
+    auto key = [](const std::string& aName) {
+        auto dash = aName.rfind('-');
+        return std::make_pair(aName.substr(0, dash), std::stoi(aName.substr(dash + 1)));
+    };
+    std::sort(rotated.begin(), rotated.end(), [&key](const auto& aLeft, const auto& aRight) {
+        return key(aLeft) < key(aRight);
+    });
+    rotated.push_back(aPath);
+    return rotated;
+}
+
+class RotatingSinkTest : public ::testing::Test {
+  protected:
+    void SetUp() override { path_ = Temp_Path("rotating.log"); }
+    void TearDown() override { Remove_All(path_); }
+
+    // Each file gets the pending file ready before the next write
+    static void Let_Rotator_Run() { std::this_thread::sleep_for(std::chrono::milliseconds(20)); }
+
+    std::string path_;
+};
+
+TEST_F(RotatingSinkTest, SplitsAtTheLastRecordThatFits) {
+    constexpr std::size_t max_bytes         = 10000;
+    constexpr int         num_writes        = 30;
+    constexpr int         records_per_write = 100;
+    constexpr std::size_t max_record_bytes  = 64;
+    auto                  record            = [](int aIndex) {
+        return "Record " + std::to_string(aIndex) + std::string(aIndex % 50, '.') + "\n";
+    };
+
+    std::string expected;
+    {
+        RotatingSink sink(path_, {.max_bytes = max_bytes}, [](const std::string& aName) {
+            return std::make_unique<StreamSink>(aName);
+        });
+
+        // Batches like the async writer's, each rotating (at most once) somewhere inside
+        for (int write = 0; write < num_writes; ++write) {
+            std::string bytes;
+            for (int i = 0; i < records_per_write; ++i)
+                bytes += record(write * records_per_write + i);
+            Let_Rotator_Run();
+            sink.Write(bytes);
+            expected += bytes;
+        }
+        EXPECT_GT(sink.num_rotations(), static_cast<size_t>(0));
+        EXPECT_EQ(sink.rotation_error(), 0);
+    }
+
+    // Every rotated file ends with a whole record, and is only short of max_bytes by (less than)
+    // the record that didn't fit
+    auto files = Log_Files(path_);
+    ASSERT_GT(files.size(), static_cast<size_t>(1));
+    std::string all;
+    for (std::size_t i = 0; i < files.size(); ++i) {
+        auto bytes = Read_File(files[i]);
+        ASSERT_FALSE(bytes.empty());
+        EXPECT_EQ(bytes.back(), '\n') << files[i];
+        EXPECT_LE(bytes.size(), max_bytes) << files[i];
+        if (i + 1 < files.size()) {
+            EXPECT_GT(bytes.size(), max_bytes - max_record_bytes) << files[i];
+        }
+        all += bytes;
+    }
+
+    // Nothing lost, nothing reordered
+    EXPECT_EQ(all, expected);
+}
+
+TEST_F(RotatingSinkTest, LogFileRecordsAreNeverSplit) {
+    {
+        LogFile log(path_, {.mode = LogMode::Async, .rotation = {.max_bytes = 4096}});
+        for (int i = 0; i < 2000; ++i) {
+            log << "Record " + std::to_string(i);
+            if (i % 100 == 0)
+                Let_Rotator_Run();
+        }
+    }
+
+    // Each file holds whole records; together, all of them in order
+    int next = 0;
+    for (const auto& file : Log_Files(path_)) {
+        auto bytes = Read_File(file);
+        ASSERT_FALSE(bytes.empty());
+        EXPECT_EQ(bytes.back(), '\n') << file;
+        for (const auto& line : Read_Lines(file)) {
+            auto message = Message(line);
+            if (message.starts_with("Record ")) {
+                EXPECT_EQ(message, "Record " + std::to_string(next++));
+            }
+        }
+    }
+    EXPECT_EQ(next, 2000);
+}
+
+TEST_F(RotatingSinkTest, NeverOverwritesAnArchive) {
+    // What an earlier process rotated to, within the next few seconds
+    std::vector<std::string> archives;
+    auto                     now = std::time(nullptr);
+    for (std::time_t second = now; second < now + 5; ++second) {
+        std::tm time;
+        localtime_r(&second, &time);
+        char suffix[32];
+        auto size = std::strftime(suffix, sizeof(suffix), ".%Y%m%d-%H%M%S-", &time);
+        for (int sequence = 0; sequence < 2; ++sequence) {
+            archives.push_back(path_ + std::string(suffix, size) + std::to_string(sequence));
+            std::ofstream(archives.back()) << "Archive\n";
+        }
+    }
+
+    {
+        RotatingSink sink(path_, {.max_bytes = 100}, [](const std::string& aName) {
+            return std::make_unique<StreamSink>(aName);
+        });
+        Let_Rotator_Run();
+        sink.Write(std::string(80, 'a') + "\n" + std::string(80, 'b') + "\n");
+        Let_Rotator_Run();
+        EXPECT_EQ(sink.num_rotations(), static_cast<size_t>(1));
+    }
+
+    for (const auto& archive : archives)
+        EXPECT_EQ(Read_File(archive), "Archive\n") << archive;
+    auto files = Log_Files(path_);
+    ASSERT_EQ(files.size(), archives.size() + 2);
+    EXPECT_EQ(Read_File(path_), std::string(80, 'b') + "\n");
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,63 @@
+#include <gtest/gtest.h>
+
+#include <ctime>
+#include <string>
+
+#include "Timestamp.hpp"
+
+// What the cache should produce for aSecond, from strftime()
+std::string Expected_Date_Time(std::time_t aSecond) {
+    std::tm time;
+    localtime_r(&aSecond, &time);
+    char text[32];
+    auto size = std::strftime(text, sizeof(text), "[%Y-%m-%d %H:%M:%S", &time);
+    return std::string(text, size);
+}
+
+timespec Time(std::time_t aSecond, long aNanosecond) {
+    timespec time;
+    time.tv_sec  = aSecond;
+    time.tv_nsec = aNanosecond;
+    return time;
+}
+
+TEST(TimestampCacheTest, FormatsEachPrecision) {
+    constexpr std::time_t second = 1'700'000'000;
+    auto                  date   = Expected_Date_Time(second);
+
+    TimestampCache seconds(TimestampPrecision::Seconds);
+    EXPECT_EQ(seconds.Prefix(Time(second, 123'456'789)), date + "] ");
+
+    TimestampCache milliseconds(TimestampPrecision::Milliseconds);
+    EXPECT_EQ(milliseconds.Prefix(Time(second, 123'456'789)), date + ".123] ");
+    EXPECT_EQ(milliseconds.Prefix(Time(second, 7'000'000)), date + ".007] ");
+
+    TimestampCache microseconds(TimestampPrecision::Microseconds);
+    EXPECT_EQ(microseconds.Prefix(Time(second, 123'456'789)), date + ".123456] ");
+    EXPECT_EQ(microseconds.Prefix(Time(second, 999)), date + ".000000] ");
+}
+
+TEST(TimestampCacheTest, ReformatsWhenTheSecondChanges) {
+    // Including across a minute, a day and a year, and backwards (a clock step)
+    TimestampCache cache(TimestampPrecision::Milliseconds);
+    for (std::time_t second : {1'699'999'999L, 1'700'000'000L, 1'700'000'000L, 1'700'000'059L,
+                               1'700'000'060L, 1'703'980'799L, 1'703'980'800L, 1'699'999'999L}) {
+        auto prefix = cache.Prefix(Time(second, 250'000'000));
+        EXPECT_EQ(prefix, Expected_Date_Time(second) + ".250] ") << second;
+    }
+}
+
+TEST(TimestampCacheTest, PrefixIsTheCurrentTime) {
+    TimestampCache cache(TimestampPrecision::Seconds);
+    auto           before = std::time(nullptr);
+    auto           prefix = std::string(cache.Prefix());
+    auto           after  = std::time(nullptr);
+    EXPECT_TRUE((prefix == Expected_Date_Time(before) + "] ") ||
+                (prefix == Expected_Date_Time(after) + "] "))
+        << prefix;
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,108 @@
+#include <gtest/gtest.h>
+#include <linux/filter.h>
+#include <linux/seccomp.h>
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <string>
+
+#include "UringSink.hpp"
+#include "log_test_utils.hpp"
+
+// A pattern that can't line up with the sink's buffers: a misplaced or repeated chunk shows
+std::string Pattern(std::size_t aSize) {
+    std::string bytes(aSize, '\0');
+    for (std::size_t i = 0; i < aSize; ++i)
+        bytes[i] = static_cast<char>('a' + (i * 7 + i / 1021) % 26);
+    return bytes;
+}
+
+// Written in odd-sized pieces, so they straddle the buffers, over several times all of them
+void Write_Pattern(UringSink& aSink, const std::string& aBytes) {
+    constexpr std::size_t piece = 3001;
+    for (std::size_t offset = 0; offset < aBytes.size(); offset += piece)
+        aSink.Write(std::string_view(aBytes).substr(offset, piece));
+}
+
+class UringSinkTest : public ::testing::Test {
+  protected:
+    void SetUp() override { path_ = Temp_Path("uring.log"); }
+    void TearDown() override { Remove_All(path_); }
+
+    static constexpr std::size_t num_bytes_ =
+        3 * UringSink::sNumBuffers * UringSink::sBufferBytes + 12345;
+
+    std::string path_;
+};
+
+TEST_F(UringSinkTest, WritesEveryByteInOrder) {
+    auto bytes = Pattern(num_bytes_);
+    {
+        UringSink sink(path_);
+        if (!sink.is_uring())
+            GTEST_SKIP() << "io_uring isn't available";
+        Write_Pattern(sink, bytes);
+        sink.Sync();
+        EXPECT_EQ(Read_File(path_), bytes);
+        Write_Pattern(sink, bytes);
+    }
+    EXPECT_EQ(Read_File(path_), bytes + bytes);
+}
+
+TEST_F(UringSinkTest, AppendsToAnExistingFile) {
+    {
+        UringSink sink(path_);
+        sink.Write(std::string_view("First\n"));
+    }
+    {
+        UringSink sink(path_);
+        sink.Write(std::string_view("Second\n"));
+    }
+    EXPECT_EQ(Read_File(path_), "First\nSecond\n");
+}
+
+TEST_F(UringSinkTest, FallsBackToPwrite) {
+    constexpr int skipped = 77;
+    auto          bytes   = Pattern(num_bytes_);
+
+    // In a child process, with io_uring_setup() failing as a seccomp filter (or an old kernel)
+    // makes it
+    auto child = fork();
+    ASSERT_GE(child, 0);
+    if (child == 0) {
+        sock_filter filter[] = {
+            BPF_STMT(BPF_LD | BPF_W | BPF_ABS, offsetof(seccomp_data, nr)),
+            BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, __NR_io_uring_setup, 0, 1),
+            BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_ERRNO | ENOSYS),
+            BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_ALLOW),
+        };
+        sock_fprog program = {.len = sizeof(filter) / sizeof(filter[0]), .filter = filter};
+        if ((prctl(PR_SET_NO_NEW_PRIVS, 1, 0, 0, 0) != 0) ||
+            (prctl(PR_SET_SECCOMP, SECCOMP_MODE_FILTER, &program) != 0))
+            _exit(skipped);
+
+        UringSink sink(path_);
+        if (sink.is_uring())
+            _exit(1);
+        Write_Pattern(sink, bytes);
+        sink.Sync();
+        _exit(0);
+    }
+
+    int status = 0;
+    ASSERT_EQ(waitpid(child, &status, 0), child);
+    ASSERT_TRUE(WIFEXITED(status));
+    if (WEXITSTATUS(status) == skipped)
+        GTEST_SKIP() << "Can't install a seccomp filter";
+    ASSERT_EQ(WEXITSTATUS(status), 0) << "io_uring wasn't blocked";
+    EXPECT_EQ(Read_File(path_), bytes);
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}